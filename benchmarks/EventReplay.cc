@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Plays a recording made with FLUENT_RECORD_FILE back against offscreen
+// decorations and reports what the decorations spent painting in response
+// to every kind of event. Recorded sessions (caption churn, hover sweeps,
+// resize drags) turn into repeatable benchmarks.
+//
+// Events are replayed at the time they were recorded, with the event loop
+// running in between, so timers like the caption throttle fire the way
+// they did in KWin. Repaints those timers cause are reported on their own.
+
+// own
+#include "Decoration.h"
+#include "EventRecorder.h"
+#include "StandIn.h"
+
+// Qt
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QGuiApplication>
+#include <QHash>
+#include <QHoverEvent>
+#include <QImage>
+#include <QMap>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QTextStream>
+#include <QTimer>
+
+using namespace Fluent;
+using EventRecorder::EventType;
+
+namespace
+{
+    const char *eventTypeName(EventType type)
+    {
+        switch (type) {
+            case EventType::Created: return "created";
+            case EventType::Destroyed: return "destroyed";
+            case EventType::Caption: return "caption";
+            case EventType::Active: return "active";
+            case EventType::Maximized: return "maximized";
+            case EventType::Shaded: return "shaded";
+            case EventType::Size: return "size";
+            case EventType::Closeable: return "closeable";
+            case EventType::Maximizeable: return "maximizeable";
+            case EventType::Minimizeable: return "minimizeable";
+            case EventType::ProvidesContextHelp: return "context-help";
+            case EventType::AdjacentScreenEdges: return "screen-edges";
+            case EventType::Desktop: return "desktop";
+            case EventType::OnAllDesktops: return "all-desktops";
+            case EventType::HoverEnter: return "hover-enter";
+            case EventType::HoverMove: return "hover-move";
+            case EventType::HoverLeave: return "hover-leave";
+            case EventType::MousePress: return "mouse-press";
+            case EventType::MouseRelease: return "mouse-release";
+            case EventType::MouseMove: return "mouse-move";
+        }
+        return "unknown";
+    }
+
+    void applyState(Bench::StandInClient *client, const QVariantMap &state)
+    {
+        client->setCaption(state.value(QStringLiteral("caption")).toString());
+        client->setActive(state.value(QStringLiteral("active")).toBool());
+        client->setMaximized(state.value(QStringLiteral("maximized")).toBool());
+        client->setShaded(state.value(QStringLiteral("shaded")).toBool());
+        client->setSize(state.value(QStringLiteral("size")).toSize());
+        client->setCloseable(state.value(QStringLiteral("closeable")).toBool());
+        client->setMaximizeable(state.value(QStringLiteral("maximizeable")).toBool());
+        client->setMinimizeable(state.value(QStringLiteral("minimizeable")).toBool());
+        client->setProvidesContextHelp(state.value(QStringLiteral("providesContextHelp")).toBool());
+        client->setAdjacentScreenEdges(Qt::Edges(state.value(QStringLiteral("adjacentScreenEdges")).toInt()));
+        client->setDesktop(state.value(QStringLiteral("desktop")).toInt());
+        client->setOnAllDesktops(state.value(QStringLiteral("onAllDesktops")).toBool());
+    }
+
+    void applyProperty(Bench::StandInClient *client, const EventRecorder::Event &event)
+    {
+        switch (event.type) {
+            case EventType::Caption: client->setCaption(event.value.toString()); break;
+            case EventType::Active: client->setActive(event.value.toBool()); break;
+            case EventType::Maximized: client->setMaximized(event.value.toBool()); break;
+            case EventType::Shaded: client->setShaded(event.value.toBool()); break;
+            case EventType::Size: client->setSize(event.value.toSize()); break;
+            case EventType::Closeable: client->setCloseable(event.value.toBool()); break;
+            case EventType::Maximizeable: client->setMaximizeable(event.value.toBool()); break;
+            case EventType::Minimizeable: client->setMinimizeable(event.value.toBool()); break;
+            case EventType::ProvidesContextHelp: client->setProvidesContextHelp(event.value.toBool()); break;
+            case EventType::AdjacentScreenEdges: client->setAdjacentScreenEdges(Qt::Edges(event.value.toInt())); break;
+            case EventType::Desktop: client->setDesktop(event.value.toInt()); break;
+            case EventType::OnAllDesktops: client->setOnAllDesktops(event.value.toBool()); break;
+            default: break;
+        }
+    }
+
+    void sendInput(Decoration *decoration, const EventRecorder::Event &event)
+    {
+        const auto button = Qt::MouseButton(event.button);
+        const auto buttons = Qt::MouseButtons(int(event.buttons));
+
+        switch (event.type) {
+            case EventType::HoverEnter:
+            case EventType::HoverMove:
+            case EventType::HoverLeave: {
+                const QEvent::Type type = event.type == EventType::HoverEnter ? QEvent::HoverEnter
+                                          : event.type == EventType::HoverMove ? QEvent::HoverMove
+                                          : QEvent::HoverLeave;
+                QHoverEvent hover(type, event.position, QPointF(-1, -1));
+                QCoreApplication::sendEvent(decoration, &hover);
+                break;
+            }
+
+            case EventType::MousePress:
+            case EventType::MouseRelease:
+            case EventType::MouseMove: {
+                const QEvent::Type type = event.type == EventType::MousePress ? QEvent::MouseButtonPress
+                                          : event.type == EventType::MouseRelease ? QEvent::MouseButtonRelease
+                                          : QEvent::MouseMove;
+                QMouseEvent mouse(type, event.position, button, buttons, Qt::NoModifier);
+                QCoreApplication::sendEvent(decoration, &mouse);
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    struct Cost
+    {
+        int events = 0;
+        int paints = 0;
+        qint64 paintNs = 0;
+    };
+
+    // Runs the event loop, timers included, until the replay clock
+    // reaches the given time in microseconds.
+    void runUntil(const QElapsedTimer &clock, qint64 time)
+    {
+        const qint64 remainingMs = (time - clock.nsecsElapsed() / 1000) / 1000;
+        if (remainingMs > 0) {
+            QEventLoop loop;
+            QTimer::singleShot(int(remainingMs), Qt::PreciseTimer, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        QCoreApplication::processEvents();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Replays a recorded decoration event trace"));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("recording"), QStringLiteral("File written via FLUENT_RECORD_FILE."));
+
+    QCommandLineOption dprOption(QStringLiteral("dpr"),
+            QStringLiteral("Device pixel ratio to paint with."), QStringLiteral("ratio"), QStringLiteral("1"));
+    parser.addOption(dprOption);
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    const qreal devicePixelRatio = qMax(0.5, parser.value(dprOption).toDouble());
+
+    QFile file(parser.positionalArguments().first());
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical("Could not open %s", qPrintable(file.fileName()));
+        return 1;
+    }
+
+    QDataStream stream(&file);
+    if (!EventRecorder::readHeader(stream)) {
+        qCritical("%s is not a decoration recording", qPrintable(file.fileName()));
+        return 1;
+    }
+
+    Bench::StandInBridge bridge;
+    QHash<quint32, Decoration *> decorations;
+    QMap<QString, Cost> costs;
+    Cost total;
+
+    QImage canvas;
+
+    // Paints what the decoration damaged, the way KWin would.
+    auto paint = [&] (Decoration *decoration, const QRect &damage, Cost &cost) {
+        const QRect rect = decoration->rect();
+        if (canvas.size() != rect.size() * devicePixelRatio) {
+            canvas = QImage(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+            canvas.setDevicePixelRatio(devicePixelRatio);
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        QPainter painter(&canvas);
+        painter.setClipRect(damage & rect);
+        decoration->paint(&painter, damage & rect);
+        painter.end();
+        const qint64 ns = timer.nsecsElapsed();
+
+        ++cost.paints;
+        cost.paintNs += ns;
+        ++total.paints;
+        total.paintNs += ns;
+    };
+
+    // Repaints caused by timers rather than by an event, such as a
+    // throttled caption.
+    Cost &timerCost = costs[QStringLiteral("timers")];
+    auto paintTimerDamage = [&] {
+        for (Decoration *decoration : qAsConst(decorations)) {
+            const QRegion damage = bridge.damage(decoration);
+            if (!damage.isEmpty()) {
+                paint(decoration, damage.boundingRect(), timerCost);
+            }
+        }
+    };
+
+    QElapsedTimer clock;
+    qint64 startTime = 0;
+    qint64 lastTime = 0;
+
+    EventRecorder::Event event;
+    while (EventRecorder::readEvent(stream, event)) {
+        if (!clock.isValid()) {
+            startTime = event.time;
+            clock.start();
+        }
+        lastTime = event.time - startTime;
+
+        bridge.resetDamage();
+        runUntil(clock, lastTime);
+        paintTimerDamage();
+        bridge.resetDamage();
+
+        Decoration *decoration = decorations.value(event.decoration);
+
+        if (event.type == EventType::Created) {
+            decoration = bridge.createDecoration();
+            applyState(bridge.client(decoration), event.value.toMap());
+            decorations.insert(event.decoration, decoration);
+        } else if (!decoration) {
+            continue;
+        } else if (event.type == EventType::Destroyed) {
+            decorations.remove(event.decoration);
+            delete decoration;
+            decoration = nullptr;
+        } else if (event.isInput()) {
+            sendInput(decoration, event);
+        } else {
+            applyProperty(bridge.client(decoration), event);
+        }
+
+        // Delayed relayouts and deferred deletions.
+        QCoreApplication::sendPostedEvents();
+
+        Cost &cost = costs[QLatin1String(eventTypeName(event.type))];
+        ++cost.events;
+        ++total.events;
+
+        if (event.type == EventType::Created) {
+            paint(decoration, decoration->rect(), cost);
+        } else if (decoration && !bridge.damage(decoration).isEmpty()) {
+            paint(decoration, bridge.damage(decoration).boundingRect(), cost);
+        }
+    }
+
+    // Give the throttles a second to deliver what is still pending.
+    bridge.resetDamage();
+    runUntil(clock, lastTime + 1000 * 1000);
+    paintTimerDamage();
+
+    qDeleteAll(decorations);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+    QTextStream out(stdout);
+    out << "event            count   paints  paint total(us)  paint/event(us)\n";
+
+    auto printRow = [&out] (const QString &name, const Cost &cost) {
+        out << name.leftJustified(15) << "  "
+            << qSetFieldWidth(5) << cost.events << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(7) << cost.paints << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(15) << (cost.paintNs / 1000.0) << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(15) << (cost.events ? cost.paintNs / 1000.0 / cost.events : 0.0) << qSetFieldWidth(0)
+            << "\n";
+    };
+
+    for (auto it = costs.constBegin(); it != costs.constEnd(); ++it) {
+        printRow(it.key(), it.value());
+    }
+    out << "\n";
+    printRow(QStringLiteral("total"), total);
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Creates and destroys N decorations against stand-in clients, the way a
+// session with hundreds of windows (or the KCM with its previews) does, and
+// reports how construction, init, destruction and memory scale.
+
+// own
+#include "Decoration.h"
+#include "StandIn.h"
+
+// Qt
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <QTextStream>
+#include <QVector>
+
+using namespace Fluent;
+
+int main(int argc, char **argv)
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Decoration lifecycle stress benchmark"));
+    parser.addHelpOption();
+
+    QCommandLineOption countOption(QStringLiteral("count"),
+            QStringLiteral("Number of concurrent decorations."), QStringLiteral("N"), QStringLiteral("500"));
+    QCommandLineOption roundsOption(QStringLiteral("rounds"),
+            QStringLiteral("Number of create/destroy rounds."), QStringLiteral("N"), QStringLiteral("5"));
+    parser.addOption(countOption);
+    parser.addOption(roundsOption);
+    parser.process(app);
+
+    const int count = qMax(1, parser.value(countOption).toInt());
+    const int rounds = qMax(1, parser.value(roundsOption).toInt());
+
+    QTextStream out(stdout);
+
+    Bench::StandInBridge bridge;
+
+    QVector<Decoration *> decorations;
+    decorations.reserve(count);
+
+    out << "decorations: " << count << ", rounds: " << rounds << "\n\n";
+    // Buttons and the rest of what init() defers are only created by the
+    // first paint, so creation is timed through it.
+    out << "round  create+paint/deco(us)  first-frame(us)  destroy/deco(us)  rss/deco(KiB)  shadows(live->after)  generated\n";
+
+    QImage canvas(QSize(800, 64), QImage::Format_ARGB32_Premultiplied);
+
+    for (int round = 0; round < rounds; ++round) {
+        const qint64 rssBefore = Bench::residentSetSize();
+        const int generatedBefore = Decoration::shadowGenerationCount();
+
+        // Every decoration is painted, and its time to first frame sampled,
+        // before the next one is created. Otherwise the time to first
+        // frame would include creating all the later decorations.
+        QElapsedTimer timer;
+        timer.start();
+        qint64 timeToFirstFrame = 0;
+        for (int i = 0; i < count; ++i) {
+            Decoration *decoration = bridge.createDecoration();
+            decorations.append(decoration);
+
+            QPainter painter(&canvas);
+            decoration->paint(&painter, decoration->rect());
+            timeToFirstFrame += decoration->timeToFirstFrame();
+        }
+        const qint64 createNs = timer.nsecsElapsed();
+
+        // Make half of the windows inactive so that both shadows are in
+        // use, then let the shadows the first paints deferred catch up.
+        for (int i = 0; i < count; i += 2) {
+            bridge.client(decorations.at(i))->setActive(false);
+        }
+        QCoreApplication::processEvents();
+
+        const qint64 rssLive = Bench::residentSetSize();
+        const int liveShadows = Decoration::cachedShadowCount();
+
+        timer.restart();
+        qDeleteAll(decorations);
+        decorations.clear();
+        const qint64 destroyNs = timer.nsecsElapsed();
+
+        // Deferred deletions (buttons, timers) happen in the event loop.
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+        out << qSetFieldWidth(5) << round << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(15) << (createNs / 1000.0 / count) << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(15) << (qreal(timeToFirstFrame) / count) << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(16) << (destroyNs / 1000.0 / count) << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(13) << (qreal(rssLive - rssBefore) / count) << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(12) << liveShadows << qSetFieldWidth(0) << " -> "
+            << qSetFieldWidth(4) << Decoration::cachedShadowCount() << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(9) << (Decoration::shadowGenerationCount() - generatedBefore) << qSetFieldWidth(0)
+            << "\n";
+    }
+
+    out << "\npeak rss: " << Bench::peakResidentSetSize() << " KiB\n";
+
+    return 0;
+}
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Repaints decorations whose state doesn't change and counts the heap
+// allocations made inside Decoration::paint(). Once the caches are warm
+// there should be none, so any allocation is reported as a regression and
+// the tool exits with a non-zero status.
+//
+// With glibc, malloc() and friends are replaced, which also covers
+// operator new and Qt's containers. Elsewhere only operator new is counted.
+
+// own
+#include "Decoration.h"
+#include "StandIn.h"
+
+// KDecoration
+#include <KDecoration2/DecorationButton>
+
+// Qt
+#include <QCommandLineParser>
+#include <QGuiApplication>
+#include <QHoverEvent>
+#include <QImage>
+#include <QPainter>
+#include <QTextStream>
+#include <QVector>
+
+// std
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+using namespace Fluent;
+
+namespace
+{
+    std::atomic<bool> s_counting { false };
+    std::atomic<bool> s_abortOnAllocation { false };
+    std::atomic<quint64> s_allocations { 0 };
+
+    inline void countAllocation()
+    {
+        if (Q_UNLIKELY(s_counting.load(std::memory_order_relaxed))) {
+            s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+            // Leaves a core dump (or a debugger stop) pointing right at
+            // the allocation.
+            if (s_abortOnAllocation.load(std::memory_order_relaxed)) {
+                s_counting = false;
+                std::abort();
+            }
+        }
+    }
+}
+
+#ifdef __GLIBC__
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+
+    void *malloc(size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_realloc(ptr, size);
+    }
+
+    void *memalign(size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void **ptr, size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr ? 0 : ENOMEM;
+    }
+}
+#else
+void *operator new(std::size_t size)
+{
+    countAllocation();
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+namespace
+{
+    struct Scenario
+    {
+        QString name;
+        bool active;
+        bool maximized;
+        bool hoverClose;
+        QString caption;
+        qreal devicePixelRatio;
+    };
+
+    QVector<Scenario> scenarios()
+    {
+        const QString shortCaption = QStringLiteral("Konsole");
+        const QString longCaption = QStringLiteral(
+                "A very long window caption that certainly does not fit into the title bar "
+                "of a window of this size and therefore has to be elided by the decoration");
+
+        QVector<Scenario> scenarios;
+        for (const qreal dpr : { 1.0, 2.0 }) {
+            const QString suffix = QStringLiteral("@%1x").arg(dpr);
+            scenarios << Scenario { QStringLiteral("active") + suffix, true, false, false, shortCaption, dpr };
+            scenarios << Scenario { QStringLiteral("inactive") + suffix, false, false, false, shortCaption, dpr };
+            scenarios << Scenario { QStringLiteral("hover-close") + suffix, true, false, true, shortCaption, dpr };
+            scenarios << Scenario { QStringLiteral("maximized") + suffix, true, true, false, shortCaption, dpr };
+            scenarios << Scenario { QStringLiteral("long-caption") + suffix, true, false, false, longCaption, dpr };
+        }
+        return scenarios;
+    }
+
+    void hoverClose(Decoration *decoration)
+    {
+        const auto buttons = decoration->findChildren<KDecoration2::DecorationButton *>();
+        for (const KDecoration2::DecorationButton *button : buttons) {
+            if (button->type() == KDecoration2::DecorationButtonType::Close && button->isVisible()) {
+                QHoverEvent hover(QEvent::HoverMove, button->geometry().center(), QPointF(-1, -1));
+                QCoreApplication::sendEvent(decoration, &hover);
+                return;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Counts heap allocations of steady-state repaints"));
+    parser.addHelpOption();
+
+    QCommandLineOption paintsOption(QStringLiteral("paints"),
+            QStringLiteral("Number of counted repaints per state."), QStringLiteral("N"), QStringLiteral("100"));
+    QCommandLineOption abortOption(QStringLiteral("abort"),
+            QStringLiteral("Abort on the first counted allocation, to inspect it in a debugger."));
+    parser.addOption(paintsOption);
+    parser.addOption(abortOption);
+    parser.process(app);
+
+    const int paints = qMax(1, parser.value(paintsOption).toInt());
+    s_abortOnAllocation = parser.isSet(abortOption);
+
+    QTextStream out(stdout);
+
+#ifndef __GLIBC__
+    out << "note: not built against glibc, only operator new is counted\n\n";
+#endif
+
+    Bench::StandInBridge bridge;
+
+    out << QStringLiteral("state").leftJustified(24) << "allocations/paint\n";
+
+    bool failed = false;
+    for (const Scenario &scenario : scenarios()) {
+        Decoration *decoration = bridge.createDecoration();
+        Bench::StandInClient *client = bridge.client(decoration);
+        client->setActive(scenario.active);
+        client->setMaximized(scenario.maximized);
+        client->setCaption(scenario.caption);
+        if (scenario.hoverClose) {
+            hoverClose(decoration);
+        }
+        QCoreApplication::sendPostedEvents();
+
+        QImage canvas(decoration->rect().size() * scenario.devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+        canvas.setDevicePixelRatio(scenario.devicePixelRatio);
+        canvas.fill(Qt::transparent);
+
+        // The painter itself allocates, so it lives outside of the
+        // counted part. Every paint has to leave its state as it found it.
+        QPainter painter(&canvas);
+
+        // Fills the caches: deferred init, shaped captions, icon pixmaps.
+        for (int i = 0; i < 3; ++i) {
+            decoration->paint(&painter, decoration->rect());
+        }
+
+        s_allocations = 0;
+        s_counting = true;
+        for (int i = 0; i < paints; ++i) {
+            decoration->paint(&painter, decoration->rect());
+        }
+        s_counting = false;
+
+        const quint64 allocations = s_allocations;
+        failed |= allocations > 0;
+
+        out << scenario.name.leftJustified(24)
+            << (qreal(allocations) / paints)
+            << (allocations > 0 ? "  FAIL" : "")
+            << "\n";
+
+        painter.end();
+        delete decoration;
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+
+    out << "\n" << (failed ? "FAILED" : "passed") << "\n";
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Renders shadows and complete decorations in a matrix of states and
+// compares them with stored reference images. Also times a few benchmark
+// groups and compares their medians with a stored baseline. Exits with a
+// non-zero status if anything regressed, so it can gate changes to the
+// rendering code.
+//
+// References depend on the fonts and the Qt version. The render-check test
+// pins the fonts to the bundled one, regenerate the references with the
+// fluent-render-check-update target so they come from the same setup.
+
+// own
+#include "BoxShadowHelper.h"
+#include "Decoration.h"
+#include "StandIn.h"
+
+// KDecoration
+#include <KDecoration2/DecorationButton>
+#include <KDecoration2/DecorationShadow>
+
+// Qt
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QHoverEvent>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPair>
+#include <QTextStream>
+#include <QVector>
+
+// std
+#include <algorithm>
+#include <functional>
+
+using namespace Fluent;
+
+namespace
+{
+    enum class Interaction {
+        None,
+        HoverClose,
+        PressClose,
+        HoverMaximize
+    };
+
+    struct DecorationState
+    {
+        QString name;
+        bool active;
+        bool maximized;
+        Interaction interaction;
+        QString caption;
+        qreal devicePixelRatio;
+    };
+
+    QVector<DecorationState> decorationStates()
+    {
+        const QString shortCaption = QStringLiteral("Konsole");
+        const QString longCaption = QStringLiteral(
+                "A very long window caption that certainly does not fit into the title bar "
+                "of a window of this size and therefore has to be elided by the decoration");
+
+        QVector<DecorationState> states;
+        for (const qreal dpr : { 1.0, 1.5, 2.0 }) {
+            const QString suffix = QStringLiteral("@%1x").arg(dpr);
+            states << DecorationState { QStringLiteral("active") + suffix, true, false, Interaction::None, shortCaption, dpr };
+            states << DecorationState { QStringLiteral("inactive") + suffix, false, false, Interaction::None, shortCaption, dpr };
+            states << DecorationState { QStringLiteral("hover-close") + suffix, true, false, Interaction::HoverClose, shortCaption, dpr };
+            states << DecorationState { QStringLiteral("press-close") + suffix, true, false, Interaction::PressClose, shortCaption, dpr };
+            states << DecorationState { QStringLiteral("hover-maximize") + suffix, true, false, Interaction::HoverMaximize, shortCaption, dpr };
+            states << DecorationState { QStringLiteral("maximized") + suffix, true, true, Interaction::None, shortCaption, dpr };
+            states << DecorationState { QStringLiteral("long-caption") + suffix, true, false, Interaction::None, longCaption, dpr };
+        }
+        return states;
+    }
+
+    KDecoration2::DecorationButton *findButton(Decoration *decoration, KDecoration2::DecorationButtonType type)
+    {
+        const auto buttons = decoration->findChildren<KDecoration2::DecorationButton *>();
+        for (KDecoration2::DecorationButton *button : buttons) {
+            if (button->type() == type && button->isVisible()) {
+                return button;
+            }
+        }
+        return nullptr;
+    }
+
+    void interact(Decoration *decoration, Interaction interaction)
+    {
+        if (interaction == Interaction::None) {
+            return;
+        }
+
+        const auto type = interaction == Interaction::HoverMaximize
+                          ? KDecoration2::DecorationButtonType::Maximize
+                          : KDecoration2::DecorationButtonType::Close;
+        const KDecoration2::DecorationButton *button = findButton(decoration, type);
+        if (!button) {
+            return;
+        }
+
+        const QPointF pos = button->geometry().center();
+
+        QHoverEvent hover(QEvent::HoverMove, pos, QPointF(-1, -1));
+        QCoreApplication::sendEvent(decoration, &hover);
+
+        if (interaction == Interaction::PressClose) {
+            QMouseEvent press(QEvent::MouseButtonPress, pos, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+            QCoreApplication::sendEvent(decoration, &press);
+        }
+    }
+
+    QImage render(Decoration *decoration, qreal devicePixelRatio)
+    {
+        const QRect rect = decoration->rect();
+
+        QImage image(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(devicePixelRatio);
+        image.fill(Qt::transparent);
+
+        QPainter painter(&image);
+        decoration->paint(&painter, rect);
+        painter.end();
+
+        return image;
+    }
+
+    // Largest per-channel difference and the number of pixels that differ
+    // by more than the tolerance.
+    struct ImageDiff
+    {
+        int maxDelta = 0;
+        int differingPixels = 0;
+        qreal meanDelta = 0;
+    };
+
+    ImageDiff compare(const QImage &actual, const QImage &expected, int tolerance)
+    {
+        ImageDiff diff;
+        qint64 totalDelta = 0;
+        const QImage a = actual.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        const QImage b = expected.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+        for (int y = 0; y < a.height(); ++y) {
+            const QRgb *lineA = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+            const QRgb *lineB = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+            for (int x = 0; x < a.width(); ++x) {
+                const int delta = std::max({
+                        qAbs(qRed(lineA[x]) - qRed(lineB[x])),
+                        qAbs(qGreen(lineA[x]) - qGreen(lineB[x])),
+                        qAbs(qBlue(lineA[x]) - qBlue(lineB[x])),
+                        qAbs(qAlpha(lineA[x]) - qAlpha(lineB[x])) });
+                diff.maxDelta = std::max(diff.maxDelta, delta);
+                totalDelta += delta;
+                if (delta > tolerance) {
+                    ++diff.differingPixels;
+                }
+            }
+        }
+
+        if (!a.isNull()) {
+            diff.meanDelta = qreal(totalDelta) / (qint64(a.width()) * a.height());
+        }
+        return diff;
+    }
+
+    qint64 medianNs(int iterations, const std::function<void()> &body)
+    {
+        QVector<qint64> samples;
+        samples.reserve(iterations);
+
+        QElapsedTimer timer;
+        for (int i = 0; i < iterations; ++i) {
+            timer.start();
+            body();
+            samples.append(timer.nsecsElapsed());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        return samples.at(samples.size() / 2);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Golden-image and performance check for the rendering code"));
+    parser.addHelpOption();
+
+    QCommandLineOption referenceOption(QStringLiteral("reference"),
+            QStringLiteral("Directory with reference images and the timing baseline."),
+            QStringLiteral("dir"), QStringLiteral(FLUENT_REFERENCE_DIR));
+    QCommandLineOption updateOption(QStringLiteral("update"),
+            QStringLiteral("Write new references and a new timing baseline instead of comparing."));
+    QCommandLineOption toleranceOption(QStringLiteral("tolerance"),
+            QStringLiteral("Per-channel difference that still counts as equal."), QStringLiteral("N"), QStringLiteral("2"));
+    QCommandLineOption thresholdOption(QStringLiteral("threshold"),
+            QStringLiteral("Allowed slowdown of a benchmark median, in percent."), QStringLiteral("N"), QStringLiteral("15"));
+    QCommandLineOption iterationsOption(QStringLiteral("iterations"),
+            QStringLiteral("Samples per benchmark group."), QStringLiteral("N"), QStringLiteral("50"));
+    parser.addOption(referenceOption);
+    parser.addOption(updateOption);
+    parser.addOption(toleranceOption);
+    parser.addOption(thresholdOption);
+    parser.addOption(iterationsOption);
+    parser.process(app);
+
+    const QDir referenceDir(parser.value(referenceOption));
+    const bool update = parser.isSet(updateOption);
+    const int tolerance = parser.value(toleranceOption).toInt();
+    const qreal threshold = parser.value(thresholdOption).toDouble() / 100.0;
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+
+    if (update && !QDir().mkpath(referenceDir.absolutePath())) {
+        qCritical("Could not create %s", qPrintable(referenceDir.absolutePath()));
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    int failures = 0;
+
+    auto checkImage = [&] (const QString &name, const QImage &image) {
+        const QString fileName = referenceDir.filePath(name + QStringLiteral(".png"));
+        if (update) {
+            image.save(fileName);
+            out << "updated  " << name << "\n";
+            return;
+        }
+
+        const QImage expected(fileName);
+        if (expected.isNull()) {
+            out << "MISSING  " << name << " (run with --update)\n";
+            ++failures;
+            return;
+        }
+
+        if (expected.size() != image.size()) {
+            out << "FAIL     " << name << ": size " << image.width() << "x" << image.height()
+                << ", expected " << expected.width() << "x" << expected.height() << "\n";
+            ++failures;
+            return;
+        }
+
+        const ImageDiff diff = compare(image, expected, tolerance);
+        if (diff.differingPixels > 0) {
+            out << "FAIL     " << name << ": " << diff.differingPixels << " pixels differ, max delta "
+                << diff.maxDelta << "\n";
+            image.save(referenceDir.filePath(name + QStringLiteral(".actual.png")));
+            ++failures;
+        } else {
+            out << "ok       " << name << "\n";
+        }
+    };
+
+    Bench::StandInBridge bridge;
+
+    // Complete decorations.
+    for (const DecorationState &state : decorationStates()) {
+        Decoration *decoration = bridge.createDecoration();
+        Bench::StandInClient *client = bridge.client(decoration);
+        client->setCaption(state.caption);
+        client->setActive(state.active);
+
+        // The first paint finishes the deferred part of init(), and
+        // leaves the shadow to the event loop.
+        render(decoration, state.devicePixelRatio);
+        QCoreApplication::processEvents();
+
+        client->setMaximized(state.maximized);
+        interact(decoration, state.interaction);
+
+        checkImage(QStringLiteral("decoration-") + state.name, render(decoration, state.devicePixelRatio));
+        delete decoration;
+    }
+
+    // Shadows, as handed to the compositor.
+    for (const bool active : { true, false }) {
+        Decoration *decoration = bridge.createDecoration();
+        Bench::StandInClient *client = bridge.client(decoration);
+        client->setActive(active);
+        render(decoration, 1.0);
+
+        // finishInit() doesn't create the shadow while it runs inside
+        // the first paint, it queues updateShadow() instead.
+        QCoreApplication::processEvents();
+
+        const QString name = active ? QStringLiteral("shadow-active") : QStringLiteral("shadow-inactive");
+        const auto shadow = decoration->shadow();
+        if (!shadow || shadow->shadow().isNull()) {
+            out << "FAIL     " << name << ": the decoration has no shadow\n";
+            ++failures;
+        } else {
+            checkImage(name, shadow->shadow());
+        }
+        delete decoration;
+    }
+
+    // The summed-area engine must match the kernel it replaces.
+    for (const qreal devicePixelRatio : { 1.0, 2.0 }) {
+        for (const int iterations : { 1, 3 }) {
+            const QVector<int> radii { 48, 24 };
+            const QVector<QImage> expected = BoxShadowHelper::shadowMasks(QSize(97, 97), radii, devicePixelRatio,
+                    BoxShadowHelper::BlurSettings(BoxShadowHelper::BlurEngine::Box, iterations));
+            const QVector<QImage> actual = BoxShadowHelper::shadowMasks(QSize(97, 97), radii, devicePixelRatio,
+                    BoxShadowHelper::BlurSettings(BoxShadowHelper::BlurEngine::SummedArea, iterations));
+
+            for (int i = 0; i < radii.size(); ++i) {
+                const QString name = QStringLiteral("summed-area-r%1-i%2@%3x")
+                        .arg(radii.at(i)).arg(iterations).arg(devicePixelRatio);
+                if (actual.at(i).size() != expected.at(i).size()) {
+                    out << "FAIL     " << name << ": size differs\n";
+                    ++failures;
+                    continue;
+                }
+
+                const ImageDiff diff = compare(actual.at(i), expected.at(i), tolerance);
+                if (diff.differingPixels > 0) {
+                    out << "FAIL     " << name << ": " << diff.differingPixels << " pixels differ, max delta "
+                        << diff.maxDelta << "\n";
+                    ++failures;
+                } else {
+                    out << "ok       " << name << "\n";
+                }
+            }
+        }
+    }
+
+    // The distance field engine is exact along straight edges only,
+    // past convex corners it is too dark. Report how far it is from
+    // the Gaussian engine and fail if that grows past what DistanceField.h
+    // documents.
+    for (const qreal devicePixelRatio : { 1.0, 2.0 }) {
+        const QVector<int> radii { 48, 24, 12 };
+        const QVector<QImage> expected = BoxShadowHelper::shadowMasks(QSize(97, 97), radii, devicePixelRatio,
+                BoxShadowHelper::BlurSettings(BoxShadowHelper::BlurEngine::Gaussian, 3));
+        const QVector<QImage> actual = BoxShadowHelper::shadowMasks(QSize(97, 97), radii, devicePixelRatio,
+                BoxShadowHelper::BlurSettings(BoxShadowHelper::BlurEngine::DistanceField, 3));
+
+        for (int i = 0; i < radii.size(); ++i) {
+            const QString name = QStringLiteral("distance-field-r%1@%2x").arg(radii.at(i)).arg(devicePixelRatio);
+            if (actual.at(i).size() != expected.at(i).size()) {
+                out << "FAIL     " << name << ": size differs\n";
+                ++failures;
+                continue;
+            }
+
+            const ImageDiff diff = compare(actual.at(i), expected.at(i), tolerance);
+            const bool withinBounds = diff.maxDelta <= 65 && diff.meanDelta <= 10;
+            out << (withinBounds ? "ok       " : "FAIL     ") << name << ": max delta " << diff.maxDelta
+                << ", mean delta " << diff.meanDelta << "\n";
+            if (!withinBounds) {
+                ++failures;
+            }
+        }
+    }
+
+    // Radii are in logical pixels. A mask at twice the scale, scaled back
+    // down, must match the one at 1x, whatever the engine.
+    const QVector<QPair<QString, BoxShadowHelper::BlurEngine>> engines {
+        { QStringLiteral("box"), BoxShadowHelper::BlurEngine::Box },
+        { QStringLiteral("summed-area"), BoxShadowHelper::BlurEngine::SummedArea },
+        { QStringLiteral("extended-box"), BoxShadowHelper::BlurEngine::ExtendedBox },
+        { QStringLiteral("gaussian"), BoxShadowHelper::BlurEngine::Gaussian },
+        { QStringLiteral("distance-field"), BoxShadowHelper::BlurEngine::DistanceField }
+    };
+    for (const auto &engine : engines) {
+        const QVector<int> radii { 48, 24 };
+        const BoxShadowHelper::BlurSettings settings(engine.second, 3);
+        const QVector<QImage> expected = BoxShadowHelper::shadowMasks(QSize(97, 97), radii, 1.0, settings);
+        const QVector<QImage> actual = BoxShadowHelper::shadowMasks(QSize(97, 97), radii, 2.0, settings);
+
+        for (int i = 0; i < radii.size(); ++i) {
+            const QString name = QStringLiteral("mask-scale-%1-r%2@2x").arg(engine.first).arg(radii.at(i));
+            if (actual.at(i).size() != expected.at(i).size() * 2) {
+                out << "FAIL     " << name << ": size differs\n";
+                ++failures;
+                continue;
+            }
+
+            const QImage scaled = actual.at(i).scaled(expected.at(i).size(), Qt::IgnoreAspectRatio,
+                                                      Qt::SmoothTransformation);
+            const ImageDiff diff = compare(scaled, expected.at(i), 8);
+            if (diff.differingPixels > 0) {
+                out << "FAIL     " << name << ": " << diff.differingPixels << " pixels differ, max delta "
+                    << diff.maxDelta << "\n";
+                ++failures;
+            } else {
+                out << "ok       " << name << "\n";
+            }
+        }
+    }
+
+    // Timing groups.
+    QJsonObject medians;
+
+    medians.insert(QStringLiteral("boxShadow"), medianNs(iterations, [] {
+        QImage canvas(QSize(193, 193), QImage::Format_ARGB32_Premultiplied);
+        canvas.fill(Qt::transparent);
+        QPainter painter(&canvas);
+        BoxShadowHelper::boxShadow(&painter, QRect(48, 48, 97, 97), QPoint(0, 0), 48, Qt::black);
+    }));
+
+    {
+        Decoration *decoration = bridge.createDecoration();
+        Bench::StandInClient *client = bridge.client(decoration);
+        QImage canvas(decoration->rect().size(), QImage::Format_ARGB32_Premultiplied);
+
+        auto paint = [&] {
+            QPainter painter(&canvas);
+            decoration->paint(&painter, decoration->rect());
+        };
+
+        paint();
+        medians.insert(QStringLiteral("paintActive"), medianNs(iterations, paint));
+
+        client->setActive(false);
+        medians.insert(QStringLiteral("paintInactive"), medianNs(iterations, paint));
+
+        client->setCaption(decorationStates().last().caption);
+        medians.insert(QStringLiteral("paintLongCaption"), medianNs(iterations, paint));
+
+        delete decoration;
+    }
+
+    const QString baselineFileName = referenceDir.filePath(QStringLiteral("timing-baseline.json"));
+    if (update) {
+        QFile baselineFile(baselineFileName);
+        if (baselineFile.open(QIODevice::WriteOnly)) {
+            baselineFile.write(QJsonDocument(medians).toJson());
+        }
+        out << "updated  timing baseline\n";
+    } else {
+        QFile baselineFile(baselineFileName);
+        QJsonObject baseline;
+        if (baselineFile.open(QIODevice::ReadOnly)) {
+            baseline = QJsonDocument::fromJson(baselineFile.readAll()).object();
+        }
+
+        for (auto it = medians.constBegin(); it != medians.constEnd(); ++it) {
+            const qint64 median = it.value().toVariant().toLongLong();
+            if (!baseline.contains(it.key())) {
+                out << "MISSING  timing " << it.key() << " (run with --update)\n";
+                ++failures;
+                continue;
+            }
+
+            const qint64 expected = baseline.value(it.key()).toVariant().toLongLong();
+            const bool regressed = median > expected * (1.0 + threshold);
+            out << (regressed ? "FAIL     " : "ok       ") << "timing " << it.key() << ": "
+                << median / 1000.0 << " us (baseline " << expected / 1000.0 << " us)\n";
+            if (regressed) {
+                ++failures;
+            }
+        }
+    }
+
+    if (failures > 0) {
+        out << "\n" << failures << " check(s) failed\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "StandIn.h"
+#include "Decoration.h"
+
+// KDecoration
+#include <KDecoration2/DecoratedClient>
+
+// Qt
+#include <QFile>
+
+namespace Fluent
+{
+    namespace Bench
+    {
+        StandInClient::StandInClient(KDecoration2::DecoratedClient *client, KDecoration2::Decoration *decoration, StandInBridge *bridge)
+                : DecoratedClientPrivate(client, decoration)
+                , m_bridge(bridge)
+        {
+            m_bridge->m_clients.insert(decoration, this);
+        }
+
+        StandInClient::~StandInClient()
+        {
+            m_bridge->m_clients.remove(decoration());
+        }
+
+        QColor StandInClient::color(KDecoration2::ColorGroup group, KDecoration2::ColorRole role) const
+        {
+            if (group == KDecoration2::ColorGroup::Warning) {
+                return QColor(232, 17, 35);
+            }
+
+            const QPalette::ColorGroup paletteGroup = group == KDecoration2::ColorGroup::Active
+                                                      ? QPalette::Active
+                                                      : QPalette::Inactive;
+
+            switch (role) {
+                case KDecoration2::ColorRole::Frame:
+                case KDecoration2::ColorRole::TitleBar:
+                    return m_palette.color(paletteGroup, QPalette::Window);
+
+                case KDecoration2::ColorRole::Foreground:
+                    return m_palette.color(paletteGroup, QPalette::WindowText);
+
+                default:
+                    return QColor();
+            }
+        }
+
+        void StandInClient::requestToggleMaximization(Qt::MouseButtons buttons)
+        {
+            Q_UNUSED(buttons)
+            setMaximized(!m_maximized);
+        }
+
+        void StandInClient::setActive(bool active)
+        {
+            if (m_active != active) {
+                m_active = active;
+                emit client()->activeChanged(active);
+            }
+        }
+
+        void StandInClient::setCaption(const QString &caption)
+        {
+            if (m_caption != caption) {
+                m_caption = caption;
+                emit client()->captionChanged(caption);
+            }
+        }
+
+        void StandInClient::setDesktop(int desktop)
+        {
+            if (m_desktop != desktop) {
+                m_desktop = desktop;
+                emit client()->desktopChanged(desktop);
+            }
+        }
+
+        void StandInClient::setOnAllDesktops(bool onAllDesktops)
+        {
+            if (m_onAllDesktops != onAllDesktops) {
+                m_onAllDesktops = onAllDesktops;
+                emit client()->onAllDesktopsChanged(onAllDesktops);
+            }
+        }
+
+        void StandInClient::setShaded(bool shaded)
+        {
+            if (m_shaded != shaded) {
+                m_shaded = shaded;
+                emit client()->shadedChanged(shaded);
+            }
+        }
+
+        void StandInClient::setMaximized(bool maximized)
+        {
+            if (m_maximized != maximized) {
+                m_maximized = maximized;
+                emit client()->maximizedHorizontallyChanged(maximized);
+                emit client()->maximizedVerticallyChanged(maximized);
+                emit client()->maximizedChanged(maximized);
+            }
+        }
+
+        void StandInClient::setCloseable(bool closeable)
+        {
+            if (m_closeable != closeable) {
+                m_closeable = closeable;
+                emit client()->closeableChanged(closeable);
+            }
+        }
+
+        void StandInClient::setMaximizeable(bool maximizeable)
+        {
+            if (m_maximizeable != maximizeable) {
+                m_maximizeable = maximizeable;
+                emit client()->maximizeableChanged(maximizeable);
+            }
+        }
+
+        void StandInClient::setMinimizeable(bool minimizeable)
+        {
+            if (m_minimizeable != minimizeable) {
+                m_minimizeable = minimizeable;
+                emit client()->minimizeableChanged(minimizeable);
+            }
+        }
+
+        void StandInClient::setProvidesContextHelp(bool provides)
+        {
+            if (m_providesContextHelp != provides) {
+                m_providesContextHelp = provides;
+                emit client()->providesContextHelpChanged(provides);
+            }
+        }
+
+        void StandInClient::setSize(const QSize &size)
+        {
+            if (m_size == size) {
+                return;
+            }
+
+            const QSize oldSize = m_size;
+            m_size = size;
+
+            if (oldSize.width() != size.width()) {
+                emit client()->widthChanged(size.width());
+            }
+            if (oldSize.height() != size.height()) {
+                emit client()->heightChanged(size.height());
+            }
+            emit client()->sizeChanged(size);
+        }
+
+        void StandInClient::setAdjacentScreenEdges(Qt::Edges edges)
+        {
+            if (m_adjacentEdges != edges) {
+                m_adjacentEdges = edges;
+                emit client()->adjacentScreenEdgesChanged(edges);
+            }
+        }
+
+        StandInSettings::StandInSettings(KDecoration2::DecorationSettings *parent)
+                : DecorationSettingsPrivate(parent)
+        {
+        }
+
+        QVector<KDecoration2::DecorationButtonType> StandInSettings::decorationButtonsLeft() const
+        {
+            return { KDecoration2::DecorationButtonType::Menu };
+        }
+
+        QVector<KDecoration2::DecorationButtonType> StandInSettings::decorationButtonsRight() const
+        {
+            return {
+                KDecoration2::DecorationButtonType::ContextHelp,
+                KDecoration2::DecorationButtonType::Minimize,
+                KDecoration2::DecorationButtonType::Maximize,
+                KDecoration2::DecorationButtonType::Close
+            };
+        }
+
+        StandInBridge::StandInBridge(QObject *parent)
+                : DecorationBridge(parent)
+        {
+            m_settings = QSharedPointer<KDecoration2::DecorationSettings>::create(this);
+        }
+
+        StandInBridge::~StandInBridge() { }
+
+        std::unique_ptr<KDecoration2::DecoratedClientPrivate> StandInBridge::createClient(
+                KDecoration2::DecoratedClient *client,
+                KDecoration2::Decoration *decoration)
+        {
+            return std::unique_ptr<KDecoration2::DecoratedClientPrivate>(new StandInClient(client, decoration, this));
+        }
+
+        std::unique_ptr<KDecoration2::DecorationSettingsPrivate> StandInBridge::settings(
+                KDecoration2::DecorationSettings *parent)
+        {
+            return std::unique_ptr<KDecoration2::DecorationSettingsPrivate>(new StandInSettings(parent));
+        }
+
+        void StandInBridge::update(KDecoration2::Decoration *decoration, const QRect &geometry)
+        {
+            m_damage[decoration] += geometry;
+            ++m_updateCount;
+        }
+
+        QRegion StandInBridge::damage(const KDecoration2::Decoration *decoration) const
+        {
+            return m_damage.value(decoration);
+        }
+
+        Decoration *StandInBridge::createDecoration()
+        {
+            const QVariantMap args {
+                { QStringLiteral("bridge"), QVariant::fromValue(static_cast<KDecoration2::DecorationBridge *>(this)) }
+            };
+
+            auto *decoration = new Decoration(nullptr, QVariantList { args });
+            decoration->setSettings(m_settings);
+            decoration->init();
+            return decoration;
+        }
+
+        StandInClient *StandInBridge::client(const Decoration *decoration) const
+        {
+            return m_clients.value(decoration);
+        }
+
+        QSharedPointer<KDecoration2::DecorationSettings> StandInBridge::decorationSettings() const
+        {
+            return m_settings;
+        }
+
+        void StandInBridge::resetDamage()
+        {
+            m_damage.clear();
+            m_updateCount = 0;
+        }
+
+        static qint64 readStatusField(const char *field)
+        {
+            QFile status(QStringLiteral("/proc/self/status"));
+            if (!status.open(QIODevice::ReadOnly)) {
+                return -1;
+            }
+
+            const QByteArray prefix(field);
+            for (const QByteArray &line : status.readAll().split('\n')) {
+                if (line.startsWith(prefix)) {
+                    // "VmRSS:     12345 kB"
+                    return line.mid(prefix.size()).simplified().split(' ').value(0).toLongLong();
+                }
+            }
+
+            return -1;
+        }
+
+        qint64 residentSetSize()
+        {
+            return readStatusField("VmRSS:");
+        }
+
+        qint64 peakResidentSetSize()
+        {
+            return readStatusField("VmHWM:");
+        }
+    }
+}
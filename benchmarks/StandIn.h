@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// KDecoration
+#include <KDecoration2/DecorationSettings>
+#include <KDecoration2/Private/DecoratedClientPrivate>
+#include <KDecoration2/Private/DecorationBridge>
+#include <KDecoration2/Private/DecorationSettingsPrivate>
+
+// Qt
+#include <QHash>
+#include <QPalette>
+#include <QRegion>
+#include <QSharedPointer>
+
+namespace Fluent
+{
+    class Decoration;
+
+    namespace Bench
+    {
+        class StandInBridge;
+
+        // Headless replacement for the window KWin would decorate. Every
+        // property can be changed from the outside and emits the same
+        // signal the real client would.
+        class StandInClient : public KDecoration2::DecoratedClientPrivate
+        {
+        public:
+            StandInClient(KDecoration2::DecoratedClient *client, KDecoration2::Decoration *decoration, StandInBridge *bridge);
+            ~StandInClient() override;
+
+            bool isActive() const override { return m_active; }
+            QString caption() const override { return m_caption; }
+            int desktop() const override { return m_desktop; }
+            bool isOnAllDesktops() const override { return m_onAllDesktops; }
+            bool isShaded() const override { return m_shaded; }
+            QIcon icon() const override { return QIcon(); }
+            bool isMaximized() const override { return m_maximized; }
+            bool isMaximizedHorizontally() const override { return m_maximized; }
+            bool isMaximizedVertically() const override { return m_maximized; }
+            bool isKeepAbove() const override { return false; }
+            bool isKeepBelow() const override { return false; }
+            bool isCloseable() const override { return m_closeable; }
+            bool isMaximizeable() const override { return m_maximizeable; }
+            bool isMinimizeable() const override { return m_minimizeable; }
+            bool providesContextHelp() const override { return m_providesContextHelp; }
+            bool isModal() const override { return false; }
+            bool isShadeable() const override { return true; }
+            bool isMoveable() const override { return true; }
+            bool isResizeable() const override { return true; }
+            WId windowId() const override { return 0; }
+            WId decorationId() const override { return 0; }
+            int width() const override { return m_size.width(); }
+            int height() const override { return m_size.height(); }
+            QSize size() const override { return m_size; }
+            QPalette palette() const override { return m_palette; }
+            QColor color(KDecoration2::ColorGroup group, KDecoration2::ColorRole role) const override;
+            Qt::Edges adjacentScreenEdges() const override { return m_adjacentEdges; }
+
+            void requestShowToolTip(const QString &text) override { Q_UNUSED(text) }
+            void requestHideToolTip() override { }
+            void requestClose() override { }
+            void requestToggleMaximization(Qt::MouseButtons buttons) override;
+            void requestMinimize() override { }
+            void requestContextHelp() override { }
+            void requestToggleOnAllDesktops() override { }
+            void requestToggleShade() override { }
+            void requestToggleKeepAbove() override { }
+            void requestToggleKeepBelow() override { }
+            void requestShowWindowMenu() override { }
+
+            void setActive(bool active);
+            void setCaption(const QString &caption);
+            void setDesktop(int desktop);
+            void setOnAllDesktops(bool onAllDesktops);
+            void setShaded(bool shaded);
+            void setMaximized(bool maximized);
+            void setCloseable(bool closeable);
+            void setMaximizeable(bool maximizeable);
+            void setMinimizeable(bool minimizeable);
+            void setProvidesContextHelp(bool provides);
+            void setSize(const QSize &size);
+            void setAdjacentScreenEdges(Qt::Edges edges);
+
+        private:
+            StandInBridge *m_bridge;
+            bool m_active = true;
+            QString m_caption = QStringLiteral("Stand-in window");
+            int m_desktop = 1;
+            bool m_onAllDesktops = false;
+            bool m_shaded = false;
+            bool m_maximized = false;
+            bool m_closeable = true;
+            bool m_maximizeable = true;
+            bool m_minimizeable = true;
+            bool m_providesContextHelp = true;
+            QSize m_size = QSize(800, 600);
+            Qt::Edges m_adjacentEdges;
+            QPalette m_palette;
+        };
+
+        class StandInSettings : public KDecoration2::DecorationSettingsPrivate
+        {
+        public:
+            explicit StandInSettings(KDecoration2::DecorationSettings *parent);
+
+            bool isOnAllDesktopsAvailable() const override { return true; }
+            bool isAlphaChannelSupported() const override { return true; }
+            bool isCloseOnDoubleClickOnMenu() const override { return false; }
+            QVector<KDecoration2::DecorationButtonType> decorationButtonsLeft() const override;
+            QVector<KDecoration2::DecorationButtonType> decorationButtonsRight() const override;
+            KDecoration2::BorderSize borderSize() const override { return KDecoration2::BorderSize::Normal; }
+        };
+
+        // Stands in for KWin. Creates stand-in clients for every decoration
+        // and records the damage the decorations report.
+        class StandInBridge : public KDecoration2::DecorationBridge
+        {
+        Q_OBJECT
+
+        public:
+            explicit StandInBridge(QObject *parent = nullptr);
+            ~StandInBridge() override;
+
+            std::unique_ptr<KDecoration2::DecoratedClientPrivate> createClient(
+                    KDecoration2::DecoratedClient *client,
+                    KDecoration2::Decoration *decoration) override;
+            std::unique_ptr<KDecoration2::DecorationSettingsPrivate> settings(
+                    KDecoration2::DecorationSettings *parent) override;
+            void update(KDecoration2::Decoration *decoration, const QRect &geometry) override;
+
+            // Creates and initializes a decoration the same way KWin does.
+            Decoration *createDecoration();
+
+            StandInClient *client(const Decoration *decoration) const;
+            QSharedPointer<KDecoration2::DecorationSettings> decorationSettings() const;
+
+            // Damage the decoration reported since the last resetDamage().
+            QRegion damage(const KDecoration2::Decoration *decoration) const;
+            int updateCount() const { return m_updateCount; }
+            void resetDamage();
+
+        private:
+            QSharedPointer<KDecoration2::DecorationSettings> m_settings;
+            QHash<const KDecoration2::Decoration *, StandInClient *> m_clients;
+            QHash<const KDecoration2::Decoration *, QRegion> m_damage;
+            int m_updateCount = 0;
+
+            friend class StandInClient;
+        };
+
+        // Resident and peak resident set size of this process, in KiB.
+        qint64 residentSetSize();
+        qint64 peakResidentSetSize();
+    }
+}
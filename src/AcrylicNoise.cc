@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "AcrylicNoise.h"
+#include "PainterState.h"
+
+// Qt
+#include <QBrush>
+#include <QHash>
+#include <QImage>
+#include <QPaintDevice>
+
+namespace Fluent
+{
+    namespace AcrylicNoise
+    {
+        namespace
+        {
+            const int TILE_SIZE = 64;
+
+            QPixmap renderTile(qreal devicePixelRatio)
+            {
+                const int size = qRound(TILE_SIZE * devicePixelRatio);
+
+                QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+
+                // A fixed seed keeps the texture identical across windows
+                // and KWin restarts.
+                quint32 state = 0x2545f491;
+                for (int y = 0; y < size; ++y) {
+                    QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+                    for (int x = 0; x < size; ++x) {
+                        // xorshift32
+                        state ^= state << 13;
+                        state ^= state >> 17;
+                        state ^= state << 5;
+
+                        const int value = state & 0xff;
+                        line[x] = qRgba(value, value, value, 255);
+                    }
+                }
+
+                QPixmap pixmap = QPixmap::fromImage(image);
+                pixmap.setDevicePixelRatio(devicePixelRatio);
+                return pixmap;
+            }
+
+            // The brush is kept next to the pixmap, building a textured
+            // brush allocates every time.
+            struct Tile
+            {
+                QPixmap pixmap;
+                QBrush brush;
+            };
+
+            const Tile &cachedTile(qreal devicePixelRatio)
+            {
+                static QHash<int, Tile> s_tiles;
+
+                const int key = qRound(devicePixelRatio * 100);
+                auto it = s_tiles.find(key);
+                if (it == s_tiles.end()) {
+                    const QPixmap pixmap = renderTile(devicePixelRatio);
+                    it = s_tiles.insert(key, Tile { pixmap, QBrush(pixmap) });
+                }
+
+                return *it;
+            }
+        }
+
+        const QPixmap &tile(qreal devicePixelRatio)
+        {
+            return cachedTile(devicePixelRatio).pixmap;
+        }
+
+        void paint(QPainter *painter, const QRect &rect, qreal opacity)
+        {
+            if (opacity <= 0) {
+                return;
+            }
+
+            const Tile &noise = cachedTile(painter->device()->devicePixelRatioF());
+
+            const PainterStyleGuard guard(painter);
+            painter->setOpacity(opacity);
+            painter->setBrushOrigin(rect.topLeft());
+            painter->fillRect(rect, noise.brush);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QPainter>
+#include <QPixmap>
+#include <QRect>
+
+namespace Fluent
+{
+    namespace AcrylicNoise
+    {
+        // A small tileable noise texture. It is generated once per device
+        // pixel ratio and shared by all decorations.
+        const QPixmap &tile(qreal devicePixelRatio);
+
+        // Lays the noise texture over the given rect.
+        void paint(QPainter *painter, const QRect &rect, qreal opacity);
+    }
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "BakedShadows.h"
+
+namespace Fluent
+{
+    namespace BakedShadows
+    {
+        namespace
+        {
+            const Shadow *s_shadows = nullptr;
+            int s_count = 0;
+        }
+
+        void install(const Shadow *shadows, int count)
+        {
+            s_shadows = shadows;
+            s_count = count;
+        }
+
+        QImage image(bool active)
+        {
+            for (int i = 0; i < s_count; ++i) {
+                const Shadow &shadow = s_shadows[i];
+                if (shadow.active != active) {
+                    continue;
+                }
+
+                // The const constructor keeps the image read-only and
+                // pointing at the baked data.
+                return QImage(reinterpret_cast<const uchar *>(shadow.pixels),
+                              shadow.width, shadow.height, shadow.width * 4,
+                              QImage::Format_ARGB32_Premultiplied);
+            }
+
+            return QImage();
+        }
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QImage>
+
+namespace Fluent
+{
+    // Shadows of the default configuration, rendered at build time by
+    // fluent-shadow-baker and compiled into the plugin as read-only data.
+    // Shadows are handed to KWin at scale 1 and scaled by the compositor,
+    // so one image per state covers every device pixel ratio.
+    namespace BakedShadows
+    {
+        struct Shadow
+        {
+            bool active;
+            int width;
+            int height;
+            // Premultiplied ARGB32 pixels, one word per pixel.
+            const quint32 *pixels;
+        };
+
+        // Called by the generated data when the plugin is loaded. Builds
+        // without baked shadows (the benchmarks, for one) never call it.
+        void install(const Shadow *shadows, int count);
+
+        // Wraps the baked pixels without copying them, or returns a null
+        // image if nothing was baked for the given state.
+        QImage image(bool active);
+    }
+}
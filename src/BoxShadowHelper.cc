@@ -17,12 +17,19 @@
 
 // own
 #include "BoxShadowHelper.h"
+#include "Corners.h"
+#include "DistanceField.h"
+#include "ShadowArena.h"
 
 // Qt
 #include <QVector>
 
 // std
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
+#include <numeric>
 
 
 namespace Fluent
@@ -37,7 +44,14 @@ namespace Fluent
             // As a workaround, sigma blur scale is lowered. With the lowered sigma
             // blur scale, area under the kernel equals to 0.98, which is pretty enough.
             // Maybe, it should be changed in the future.
+            //
+            // The exact engines size their canvas to the kernel instead, see
+            // shadowExtent(), and use the sigma from the spec.
             const qreal SIGMA_BLUR_SCALE = 0.4375;
+            const qreal EXACT_SIGMA_BLUR_SCALE = 0.5;
+
+            const int MIN_ITERATIONS = 1;
+            const int MAX_ITERATIONS = 5;
         }
 
         inline qreal radiusToSigma(qreal radius)
@@ -45,12 +59,26 @@ namespace Fluent
             return radius * SIGMA_BLUR_SCALE;
         }
 
+        inline qreal radiusToExactSigma(qreal radius)
+        {
+            return radius * EXACT_SIGMA_BLUR_SCALE;
+        }
+
         inline int boxSizeToRadius(int boxSize)
         {
             return (boxSize - 1) / 2;
         }
 
-        QVector<int> computeBoxSizes(int radius, int numIterations)
+        struct BoxSizes
+        {
+            std::array<int, MAX_ITERATIONS> sizes;
+            int count = 0;
+
+            const int *begin() const { return sizes.data(); }
+            const int *end() const { return sizes.data() + count; }
+        };
+
+        BoxSizes computeBoxSizes(int radius, int numIterations)
         {
             const qreal sigma = radiusToSigma(radius);
 
@@ -65,10 +93,10 @@ namespace Fluent
             const int threshold = std::round((12 * std::pow(sigma, 2) - numIterations * std::pow(lower, 2)
                                               - 4 * numIterations * lower - 3 * numIterations) / (-4 * lower - 4));
 
-            QVector<int> boxSizes;
-            boxSizes.reserve(numIterations);
+            BoxSizes boxSizes;
+            boxSizes.count = numIterations;
             for (int i = 0; i < numIterations; ++i) {
-                boxSizes.append(i < threshold ? lower : upper);
+                boxSizes.sizes[i] = i < threshold ? lower : upper;
             }
 
             return boxSizes;
@@ -124,49 +152,372 @@ namespace Fluent
             }
         }
 
+        // Summed-area table (integral image) of the alpha channel. Any box
+        // sum is four lookups. 32 bits hold 255 * 4096 * 4096, far more
+        // than a shadow canvas ever needs.
+        class SummedAreaTable
+        {
+        public:
+            explicit SummedAreaTable(const QImage &image)
+                    : m_width(image.width())
+                    , m_height(image.height())
+                    , m_sums(ShadowArena::acquire<quint32>(ShadowArena::TableSlot, size_t(m_width + 1) * (m_height + 1)))
+            {
+                std::fill(m_sums, m_sums + m_width + 1, 0);
+                for (int y = 1; y <= m_height; ++y) {
+                    at(0, y) = 0;
+                }
+
+                const int alphaStride = image.depth() >> 3;
+                const int alphaOffset = QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3;
+
+                for (int y = 0; y < m_height; ++y) {
+                    const uchar *alpha = image.constScanLine(y) + alphaOffset;
+                    quint32 rowSum = 0;
+                    for (int x = 0; x < m_width; ++x) {
+                        rowSum += alpha[x * alphaStride];
+                        at(x + 1, y + 1) = at(x + 1, y) + rowSum;
+                    }
+                }
+            }
+
+            int width() const { return m_width; }
+            int height() const { return m_height; }
+
+            // Sum over [x0, x1) x [y0, y1), pixels outside count as zero.
+            quint32 sum(int x0, int y0, int x1, int y1) const
+            {
+                x0 = qBound(0, x0, m_width);
+                x1 = qBound(0, x1, m_width);
+                y0 = qBound(0, y0, m_height);
+                y1 = qBound(0, y1, m_height);
+                return at(x1, y1) - at(x0, y1) - at(x1, y0) + at(x0, y0);
+            }
+
+        private:
+            quint32 &at(int x, int y) { return m_sums[size_t(y) * (m_width + 1) + x]; }
+            quint32 at(int x, int y) const { return m_sums[size_t(y) * (m_width + 1) + x]; }
+
+            int m_width;
+            int m_height;
+            quint32 *m_sums;
+        };
+
+        // Same result as boxBlurAlpha() (up to rounding), but the first
+        // horizontal and vertical pass is read from a table of the source,
+        // which can be shared by masks of different radii. The mask sits
+        // in the middle of the table's image. The table only holds the
+        // source, every later pass is a regular box blur.
+        void summedAreaBlurAlpha(QImage &image, const SummedAreaTable &table, int radius, int numIterations)
+        {
+            const int alphaStride = image.depth() >> 3;
+            const int alphaOffset = QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3;
+
+            const int offsetX = (table.width() - image.width()) / 2;
+            const int offsetY = (table.height() - image.height()) / 2;
+
+            const BoxSizes boxSizes = computeBoxSizes(radius, numIterations);
+            const int firstSize = boxSizes.sizes[0];
+            const int boxRadius = boxSizeToRadius(firstSize);
+            const qreal invArea = 1.0 / (firstSize * firstSize);
+
+            for (int y = 0; y < image.height(); ++y) {
+                uchar *alpha = image.scanLine(y) + alphaOffset;
+                const int y0 = y + offsetY - boxRadius;
+                const int y1 = y + offsetY + boxRadius + 1;
+                for (int x = 0; x < image.width(); ++x) {
+                    const int x0 = x + offsetX - boxRadius;
+                    const int x1 = x + offsetX + boxRadius + 1;
+                    alpha[x * alphaStride] = static_cast<uchar>(table.sum(x0, y0, x1, y1) * invArea);
+                }
+            }
+
+            if (boxSizes.count == 1) {
+                return;
+            }
+
+            QImage tmp = ShadowArena::image(ShadowArena::TransposedSlot, QSize(image.height(), image.width()), 1.0);
+            for (int i = 1; i < boxSizes.count; ++i) {
+                boxBlurPass(image, tmp, boxSizes.sizes[i]); // horizontal pass
+                boxBlurPass(tmp, image, boxSizes.sizes[i]); // vertical pass
+            }
+        }
+
         void boxBlurAlpha(QImage &image, int radius, int numIterations)
         {
             // Temporary buffer is transposed so we always read memory
             // in linear order.
-            QImage tmp(image.height(), image.width(), image.format());
+            QImage tmp = ShadowArena::image(ShadowArena::TransposedSlot, QSize(image.height(), image.width()), 1.0);
 
-            const QVector<int> boxSizes = computeBoxSizes(radius, numIterations);
+            const BoxSizes boxSizes = computeBoxSizes(radius, numIterations);
             for (const int &boxSize : boxSizes) {
                 boxBlurPass(image, tmp, boxSize); // horizontal pass
                 boxBlurPass(tmp, image, boxSize); // vertical pass
             }
         }
 
-        void boxShadow(QPainter *p, const QRect &box, const QPoint &offset, int radius, const QColor &color)
+        // The exact engines work on a float copy of the alpha channel, one
+        // line at a time. Lines are read with a stride, so the same code
+        // does both the horizontal and the vertical pass.
+        template <typename LineFilter>
+        void filterAlpha(QImage &image, const LineFilter &filter)
         {
-            const QSize size = box.size() + 2 * QSize(radius, radius);
-            const qreal dpr = p->device()->devicePixelRatioF();
+            const int alphaStride = image.depth() >> 3;
+            const int alphaOffset = QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3;
 
-            QPainter painter;
+            const int width = image.width();
+            const int height = image.height();
 
-            QImage shadow(size * dpr, QImage::Format_ARGB32_Premultiplied);
-            shadow.setDevicePixelRatio(dpr);
-            shadow.fill(Qt::transparent);
+            float *alpha = ShadowArena::acquire<float>(ShadowArena::AlphaSlot, size_t(width) * height);
+            float *scratch = ShadowArena::acquire<float>(ShadowArena::LineSlot, size_t(qMax(width, height)));
 
-            painter.begin(&shadow);
-            painter.fillRect(QRect(QPoint(radius, radius), box.size()), Qt::black);
-            painter.end();
+            for (int y = 0; y < height; ++y) {
+                const uchar *src = image.constScanLine(y) + alphaOffset;
+                float *dst = alpha + size_t(y) * width;
+                for (int x = 0; x < width; ++x) {
+                    dst[x] = src[x * alphaStride];
+                }
+            }
 
-            // There is no need to blur RGB channels. Blur the alpha
-            // channel and then give the shadow a tint of the desired color.
-            const int numIterations = 3;
-            boxBlurAlpha(shadow, radius, numIterations);
+            for (int y = 0; y < height; ++y) {
+                filter(alpha + size_t(y) * width, width, 1, scratch); // horizontal pass
+            }
+            for (int x = 0; x < width; ++x) {
+                filter(alpha + x, height, width, scratch); // vertical pass
+            }
+
+            for (int y = 0; y < height; ++y) {
+                uchar *dst = image.scanLine(y) + alphaOffset;
+                const float *src = alpha + size_t(y) * width;
+                for (int x = 0; x < width; ++x) {
+                    dst[x * alphaStride] = static_cast<uchar>(qBound(0.0f, src[x] + 0.5f, 255.0f));
+                }
+            }
+        }
+
+        // Extended box filter from "Theoretical Foundations of Gaussian
+        // Convolution by Extended Box Filtering" by Gwosdek et al. The two
+        // outermost taps get a fractional weight, so that the variance of
+        // the iterated filter matches sigma exactly.
+        void extendedBoxBlurAlpha(QImage &image, qreal sigma, int numIterations)
+        {
+            const qreal variance = sigma * sigma / numIterations;
+            const int r = qMax(0, int(std::floor(0.5 * std::sqrt(12 * variance + 1) - 0.5)));
+            const qreal alpha = (2 * r + 1) * (r * (r + 1) - 3 * variance)
+                                / (6 * (variance - (r + 1) * (r + 1)));
+            const float norm = 1.0 / (2 * r + 1 + 2 * alpha);
+            const float outer = alpha;
+
+            auto filter = [=] (float *line, int count, int stride, float *scratch) {
+                auto at = [&] (int i) -> float {
+                    return (i >= 0 && i < count) ? scratch[i] : 0.0f;
+                };
+
+                for (int iteration = 0; iteration < numIterations; ++iteration) {
+                    for (int i = 0; i < count; ++i) {
+                        scratch[i] = line[i * stride];
+                    }
+
+                    float window = 0;
+                    for (int i = -r; i <= r; ++i) {
+                        window += at(i);
+                    }
+
+                    for (int i = 0; i < count; ++i) {
+                        line[i * stride] = (window + outer * (at(i - r - 1) + at(i + r + 1))) * norm;
+                        window += at(i + r + 1) - at(i - r);
+                    }
+                }
+            };
+
+            filterAlpha(image, filter);
+        }
+
+        // Recursive Gaussian from "Recursive implementation of the Gaussian
+        // filter" by Young and van Vliet. A causal and an anti-causal third
+        // order pass per direction, whatever the radius.
+        void recursiveGaussianAlpha(QImage &image, qreal sigma)
+        {
+            if (sigma < 0.5) {
+                return;
+            }
+
+            const qreal q = sigma >= 2.5
+                            ? 0.98711 * sigma - 0.96330
+                            : 3.97156 - 4.14554 * std::sqrt(1 - 0.26891 * sigma);
+            const qreal q2 = q * q;
+            const qreal q3 = q2 * q;
+
+            const qreal b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+            const float b1 = (2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0;
+            const float b2 = -(1.4281 * q2 + 1.26661 * q3) / b0;
+            const float b3 = (0.422205 * q3) / b0;
+            const float B = 1 - (b1 + b2 + b3);
+
+            auto filter = [=] (float *line, int count, int stride, float *scratch) {
+                // The canvas has transparent margins, so zero boundary
+                // conditions are exact enough.
+                float w1 = 0, w2 = 0, w3 = 0;
+                for (int i = 0; i < count; ++i) {
+                    const float w = B * line[i * stride] + b1 * w1 + b2 * w2 + b3 * w3;
+                    scratch[i] = w;
+                    w3 = w2;
+                    w2 = w1;
+                    w1 = w;
+                }
+
+                float o1 = 0, o2 = 0, o3 = 0;
+                for (int i = count - 1; i >= 0; --i) {
+                    const float o = B * scratch[i] + b1 * o1 + b2 * o2 + b3 * o3;
+                    line[i * stride] = o;
+                    o3 = o2;
+                    o2 = o1;
+                    o1 = o;
+                }
+            };
+
+            filterAlpha(image, filter);
+        }
+
+        int shadowExtent(int radius, const BlurSettings &settings)
+        {
+            if (settings.engine == BlurEngine::Box || settings.engine == BlurEngine::SummedArea) {
+                return radius;
+            }
+
+            // Three sigmas cover 99.7% of the kernel.
+            return std::ceil(3 * radiusToExactSigma(radius));
+        }
+
+        namespace
+        {
+            QImage blankMask(int slot, const QSize &box, int extent, qreal devicePixelRatio)
+            {
+                const QSize size = box + 2 * QSize(extent, extent);
+
+                QImage mask = ShadowArena::image(slot, size * devicePixelRatio, devicePixelRatio);
+
+                QPainter painter(&mask);
+                painter.fillRect(QRect(QPoint(extent, extent), box), Qt::black);
+                painter.end();
+
+                return mask;
+            }
+
+            QImage copyToSlot(int slot, const QImage &image)
+            {
+                QImage copy = ShadowArena::image(slot, image.size(), image.devicePixelRatio());
+                std::memcpy(copy.bits(), image.constBits(), size_t(image.bytesPerLine()) * image.height());
+                return copy;
+            }
+
+            // Blurs the mask from sigma "from" up to sigma "to". Gaussians
+            // compose, so blurring with sqrt(to^2 - from^2) on top of an
+            // existing blur gives the same result as blurring from scratch.
+            void blurMaskFurther(QImage &mask, qreal from, qreal to, const BlurSettings &settings)
+            {
+                const qreal sigma = std::sqrt(to * to - from * from);
+                if (settings.engine == BlurEngine::ExtendedBox) {
+                    extendedBoxBlurAlpha(mask, sigma, qBound(MIN_ITERATIONS, settings.iterations, MAX_ITERATIONS));
+                } else {
+                    recursiveGaussianAlpha(mask, sigma);
+                }
+            }
+        }
+
+        QVector<QImage> shadowMasks(const QSize &box, const QVector<int> &radii, qreal devicePixelRatio,
+                                    const BlurSettings &settings, int cornerRadius)
+        {
+            QVector<QImage> masks(radii.size());
+            if (radii.isEmpty()) {
+                return masks;
+            }
+
+            if (settings.engine == BlurEngine::Box) {
+                // The iterated box blur only approximates a Gaussian, so
+                // its passes don't compose. Every radius gets its own.
+                for (int i = 0; i < radii.size(); ++i) {
+                    QImage mask = blankMask(ShadowArena::MaskSlot, box, shadowExtent(radii[i], settings), devicePixelRatio);
+                    boxBlurAlpha(mask, qRound(radii[i] * devicePixelRatio),
+                                 qBound(MIN_ITERATIONS, settings.iterations, MAX_ITERATIONS));
+                    masks[i] = mask.copy();
+                }
+                return masks;
+            }
+
+            if (settings.engine == BlurEngine::SummedArea) {
+                // One table of the largest canvas serves the first pass
+                // of every radius, the smaller canvases are centered in it.
+                const int largest = *std::max_element(radii.cbegin(), radii.cend());
+                const SummedAreaTable table(blankMask(ShadowArena::WorkSlot, box, shadowExtent(largest, settings), devicePixelRatio));
+                for (int i = 0; i < radii.size(); ++i) {
+                    QImage mask = blankMask(ShadowArena::MaskSlot, box, shadowExtent(radii[i], settings), devicePixelRatio);
+                    summedAreaBlurAlpha(mask, table, qRound(radii[i] * devicePixelRatio),
+                                        qBound(MIN_ITERATIONS, settings.iterations, MAX_ITERATIONS));
+                    masks[i] = mask.copy();
+                }
+                return masks;
+            }
+
+            const int extent = shadowExtent(*std::max_element(radii.cbegin(), radii.cend()), settings);
+
+            if (settings.engine == BlurEngine::DistanceField) {
+                const QPainterPath shape = Corners::roundedTopPath(QRectF(QPointF(0, 0), box * devicePixelRatio),
+                                                                   qRound(cornerRadius * devicePixelRatio));
+                const DistanceField::Field field = DistanceField::compute(shape, std::ceil(extent * devicePixelRatio));
+                for (int i = 0; i < radii.size(); ++i) {
+                    masks[i] = DistanceField::shadow(field, radiusToExactSigma(radii[i]) * devicePixelRatio, Qt::black);
+                    masks[i].setDevicePixelRatio(devicePixelRatio);
+                }
+                return masks;
+            }
 
-            painter.begin(&shadow);
+            // Go from the smallest radius to the largest, each one picking
+            // up where the previous one stopped.
+            QVector<int> order(radii.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&radii] (int a, int b) {
+                return radii[a] < radii[b];
+            });
+
+            QImage mask = blankMask(ShadowArena::WorkSlot, box, extent, devicePixelRatio);
+            qreal sigma = 0;
+            for (const int index : order) {
+                const qreal target = radiusToExactSigma(radii[index]) * devicePixelRatio;
+                if (target > sigma) {
+                    blurMaskFurther(mask, sigma, target, settings);
+                    sigma = target;
+                }
+                masks[index] = mask.copy();
+            }
+
+            return masks;
+        }
+
+        void drawShadowMask(QPainter *p, const QRect &box, const QImage &mask, const QPoint &offset, const QColor &color)
+        {
+            // Give the shadow a tint of the desired color.
+            QImage shadow = copyToSlot(ShadowArena::TintSlot, mask);
+
+            QPainter painter(&shadow);
             painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
-            painter.fillRect(shadow.rect(), color);
+            painter.fillRect(QRect(QPoint(0, 0), shadow.size() / shadow.devicePixelRatio()), color);
             painter.end();
 
             QRect shadowRect = shadow.rect();
-            shadowRect.setSize(shadowRect.size() / dpr);
+            shadowRect.setSize(shadowRect.size() / shadow.devicePixelRatio());
             shadowRect.moveCenter(box.center() + offset);
             p->drawImage(shadowRect, shadow);
         }
 
+        void boxShadow(QPainter *p, const QRect &box, const QPoint &offset, int radius, const QColor &color,
+                       const BlurSettings &settings)
+        {
+            // There is no need to blur RGB channels. Blur the alpha
+            // channel and then give the shadow a tint of the desired color.
+            const QVector<QImage> masks = shadowMasks(box.size(), { radius }, p->device()->devicePixelRatioF(), settings);
+            drawShadowMask(p, box, masks.first(), offset, color);
+        }
+
     }
 }
@@ -19,15 +19,82 @@
 
 // Qt
 #include <QColor>
+#include <QImage>
 #include <QPainter>
 #include <QPoint>
 #include <QRect>
+#include <QVector>
 
 namespace Fluent
 {
     namespace BoxShadowHelper
     {
+        enum class BlurEngine {
+            // Repeated box blurs approximating a Gaussian. Cheapest, the
+            // quality depends on the number of iterations.
+            Box,
+            // The same box blurs, but the first pass of every layer is
+            // read from one summed-area table of the source. Only that
+            // pass is saved, so it pays off with one iteration; with more,
+            // the remaining passes cost as much as with Box.
+            SummedArea,
+            // Box blurs with fractionally weighted end taps, which hit the
+            // requested sigma exactly.
+            ExtendedBox,
+            // Recursive (Young - van Vliet) Gaussian. Exact sigma, and its
+            // cost doesn't depend on the radius.
+            Gaussian,
+            // Gaussian falloff evaluated on a distance field of the shape.
+            // Follows rounded corners, and one field serves every radius.
+            DistanceField
+        };
+
+        struct BlurSettings
+        {
+            BlurSettings() = default;
+
+            BlurSettings(BlurEngine engine, int iterations)
+                    : engine(engine)
+                    , iterations(iterations) {}
+
+            bool operator==(const BlurSettings &other) const
+            {
+                return engine == other.engine && iterations == other.iterations;
+            }
+
+            bool operator!=(const BlurSettings &other) const
+            {
+                return !(*this == other);
+            }
+
+            BlurEngine engine = BlurEngine::Box;
+            int iterations = 3;
+        };
+
+        // How far the shadow of a box reaches past the box itself.
+        int shadowExtent(int radius, const BlurSettings &settings = BlurSettings());
+
+        // Blurred black masks of a box, one per radius, to be tinted and
+        // drawn with drawShadowMask(). Generating all of them in one go
+        // lets the exact engines build each radius on top of the blur of
+        // the next smaller one.
+        //
+        // The blurring happens in ShadowArena scratch memory, the returned
+        // masks are owned copies and can be kept around.
+        //
+        // Only the DistanceField engine follows a cornerRadius, rounding
+        // the top corners of the box. The other engines blur the plain box.
+        QVector<QImage> shadowMasks(const QSize &box, const QVector<int> &radii,
+                                    qreal devicePixelRatio,
+                                    const BlurSettings &settings = BlurSettings(),
+                                    int cornerRadius = 0);
+
+        // Draws a mask from shadowMasks() around the given box.
+        void drawShadowMask(QPainter *p, const QRect &box, const QImage &mask,
+                            const QPoint &offset, const QColor &color);
+
         void boxShadow(QPainter *p, const QRect &box, const QPoint &offset,
-                       int radius, const QColor &color);
+                       int radius, const QColor &color,
+                       const BlurSettings &settings = BlurSettings());
     }
 }
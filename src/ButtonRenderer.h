@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// own
+#include "FluentDecorationButton.h"
+
+// Qt
+#include <QPainter>
+
+namespace Fluent
+{
+    // The paint pipeline shared by the title bar buttons, specialized at
+    // compile time for every glyph (CRTP). A glyph class derives from
+    // ButtonRenderer<Glyph> and provides
+    //
+    //     static constexpr bool Antialiased;
+    //     void paintGlyph(QPainter *painter, const QRectF &buttonRect);
+    //
+    // It may also hide backgroundColor() or foregroundColor(). Only the
+    // paint() entry point that KDecoration calls is virtual.
+    template<typename Glyph>
+    class ButtonRenderer : public FluentDecorationButton
+    {
+    public:
+        using FluentDecorationButton::FluentDecorationButton;
+
+        void paint(QPainter *painter, const QRect &repaintRegion) final
+        {
+            Q_UNUSED(repaintRegion)
+
+            Glyph &glyph = static_cast<Glyph &>(*this);
+            const QRectF buttonRect = geometry();
+
+            const PainterStyleGuard guard(painter);
+
+            painter->setRenderHints(QPainter::Antialiasing, Glyph::Antialiased);
+
+            // Background.
+            painter->setPen(Qt::NoPen);
+            painter->setBrush(m_backgroundBrush(glyph.backgroundColor()));
+            painter->drawRect(buttonRect);
+
+            // Foreground.
+            painter->setPen(m_foregroundPen(glyph.foregroundColor()));
+            painter->setBrush(Qt::NoBrush);
+            glyph.paintGlyph(painter, buttonRect);
+        }
+    };
+}
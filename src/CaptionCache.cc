@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "CaptionCache.h"
+
+// Qt
+#include <QCache>
+#include <QPaintDevice>
+#include <QPainter>
+#include <QTextLayout>
+
+// std
+#include <limits>
+
+namespace Fluent
+{
+    namespace CaptionCache
+    {
+        namespace
+        {
+            // Enough for every caption of a busy session, while keeping the
+            // memory bounded.
+            const int MAX_ENTRIES = 256;
+
+            struct Key
+            {
+                // The font itself rather than QFont::key(), which builds a
+                // new string on every lookup.
+                QFont font;
+                int devicePixelRatio;
+                QString text;
+
+                bool operator==(const Key &other) const
+                {
+                    return devicePixelRatio == other.devicePixelRatio
+                           && text == other.text
+                           && font == other.font;
+                }
+            };
+
+            uint qHash(const Key &key, uint seed = 0)
+            {
+                return ::qHash(key.text, seed) ^ ::qHash(key.font, seed) ^ ::qHash(key.devicePixelRatio, seed);
+            }
+
+            QCache<Key, ShapedText> &cache()
+            {
+                static QCache<Key, ShapedText> s_cache(MAX_ENTRIES);
+                return s_cache;
+            }
+
+            Stats s_stats;
+
+            ShapedText *shape(const QFont &font, const QString &text)
+            {
+                QTextLayout layout(text, font);
+                layout.setCacheEnabled(true);
+
+                layout.beginLayout();
+                QTextLine line = layout.createLine();
+                if (line.isValid()) {
+                    line.setLineWidth(std::numeric_limits<int>::max() / 2);
+                }
+                layout.endLayout();
+
+                auto *shaped = new ShapedText;
+                shaped->glyphRuns = layout.glyphRuns();
+                if (line.isValid()) {
+                    shaped->size = QSizeF(line.naturalTextWidth(), line.height());
+                }
+                return shaped;
+            }
+        }
+
+        const ShapedText *shapedText(const QFont &font, qreal devicePixelRatio, const QString &text)
+        {
+            const Key key { font, qRound(devicePixelRatio * 100), text };
+
+            if (const ShapedText *shaped = cache().object(key)) {
+                ++s_stats.hits;
+                return shaped;
+            }
+
+            ++s_stats.misses;
+
+            ShapedText *shaped = shape(font, text);
+            cache().insert(key, shaped);
+            return shaped;
+        }
+
+        void drawText(QPainter *painter, const QRectF &rect, const QFont &font, const QString &text)
+        {
+            if (text.isEmpty()) {
+                return;
+            }
+
+            const ShapedText *shaped = shapedText(font, painter->device()->devicePixelRatioF(), text);
+            const QPointF origin(rect.left(), rect.top() + (rect.height() - shaped->size.height()) / 2);
+
+            for (const QGlyphRun &glyphRun : shaped->glyphRuns) {
+                painter->drawGlyphRun(origin, glyphRun);
+            }
+        }
+
+        Stats stats()
+        {
+            Stats stats = s_stats;
+            stats.entries = cache().count();
+            return stats;
+        }
+    }
+}
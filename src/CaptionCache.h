@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QFont>
+#include <QGlyphRun>
+#include <QList>
+#include <QSizeF>
+#include <QString>
+
+namespace Fluent
+{
+    // Plugin-wide cache of shaped captions. Many windows show the same
+    // caption (or the same elided prefix), so the text is shaped once and
+    // every decoration draws the resulting glyph runs.
+    namespace CaptionCache
+    {
+        struct ShapedText
+        {
+            QList<QGlyphRun> glyphRuns;
+            QSizeF size;
+        };
+
+        struct Stats
+        {
+            quint64 hits = 0;
+            quint64 misses = 0;
+            int entries = 0;
+
+            qreal hitRate() const
+            {
+                const quint64 lookups = hits + misses;
+                return lookups ? qreal(hits) / lookups : 0;
+            }
+        };
+
+        // Returns the shaped text. The pointer stays valid until the next
+        // call to shapedText().
+        const ShapedText *shapedText(const QFont &font, qreal devicePixelRatio, const QString &text);
+
+        // Draws the text left aligned and vertically centered in the rect.
+        void drawText(QPainter *painter, const QRectF &rect, const QFont &font, const QString &text);
+
+        Stats stats();
+    }
+}
@@ -29,7 +29,7 @@
 namespace Fluent
 {
     CloseButton::CloseButton(Decoration *decoration, QObject *parent)
-            : FluentDecorationButton(KDecoration2::DecorationButtonType::Close, decoration, parent)
+            : ButtonRenderer(KDecoration2::DecorationButtonType::Close, decoration, parent)
     {
         auto *decoratedClient = decoration->client().toStrongRef().data();
         connect(decoratedClient, &KDecoration2::DecoratedClient::closeableChanged,
@@ -38,51 +38,29 @@ namespace Fluent
         setVisible(decoratedClient->isCloseable());
     }
 
-    void CloseButton::paint(QPainter *painter, const QRect &repaintRegion)
+    void CloseButton::paintGlyph(QPainter *painter, const QRectF &buttonRect)
     {
-        Q_UNUSED(repaintRegion)
-
-        const QRectF buttonRect = geometry();
         QRectF crossRect = QRectF(0, 0, 10, 10);
         crossRect.moveCenter(buttonRect.center().toPoint());
 
-        painter->save();
-
-        painter->setRenderHints(QPainter::Antialiasing, false);
-
-        // Background.
-        painter->setPen(Qt::NoPen);
-        painter->setBrush(backgroundColor());
-        painter->drawRect(buttonRect);
-
-        // Foreground.
-        painter->setPen(foregroundColor());
-        painter->setBrush(Qt::NoBrush);
         painter->drawLine(crossRect.topLeft(), crossRect.bottomRight());
         painter->drawLine(crossRect.topRight(), crossRect.bottomLeft());
-
-        painter->restore();
     }
 
     QColor CloseButton::backgroundColor() const
     {
-        const auto *deco = qobject_cast<Decoration *>(decoration());
-        if (!deco) {
-            return {};
-        }
-
         if (isPressed()) {
-            auto *decoratedClient = deco->client().toStrongRef().data();
+            auto *decoratedClient = m_decoration->client().toStrongRef().data();
             const auto color = decoratedClient->color(
                     KDecoration2::ColorGroup::Warning,
                     KDecoration2::ColorRole::Foreground
             );
 
-            return KColorUtils::mix(color, deco->titleBarBackgroundColor(), 0.3);
+            return KColorUtils::mix(color, m_decoration->titleBarBackgroundColor(), 0.3);
         }
 
         if (isHovered()) {
-            auto *decoratedClient = deco->client().toStrongRef().data();
+            auto *decoratedClient = m_decoration->client().toStrongRef().data();
             return decoratedClient->color(
                     KDecoration2::ColorGroup::Warning,
                     KDecoration2::ColorRole::Foreground
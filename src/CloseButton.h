@@ -18,7 +18,7 @@
 #pragma once
 
 // own
-#include "FluentDecorationButton.h"
+#include "ButtonRenderer.h"
 
 // KDecoration
 #include <KDecoration2/DecorationButton>
@@ -27,16 +27,20 @@ namespace Fluent
 {
     class Decoration;
 
-    class CloseButton : public FluentDecorationButton
+    class CloseButton : public ButtonRenderer<CloseButton>
     {
     Q_OBJECT
 
     public:
         CloseButton(Decoration *decoration, QObject *parent = nullptr);
 
-        void paint(QPainter *painter, const QRect &repaintRegion) override;
+    private:
+        static constexpr bool Antialiased = false;
+        void paintGlyph(QPainter *painter, const QRectF &buttonRect);
 
-    protected:
-        QColor backgroundColor() const override;
+        // Red when hovered or pressed.
+        QColor backgroundColor() const;
+
+        friend class ButtonRenderer<CloseButton>;
     };
 }
@@ -23,13 +23,36 @@
 #include <KDecoration2/DecoratedClient>
 
 // Qt
+#include <QFontMetrics>
 #include <QPainter>
 #include <QPainterPath>
 
 namespace Fluent
 {
+    namespace
+    {
+        QPixmap renderGlyph(QFont font, const QColor &color, qreal devicePixelRatio)
+        {
+            font.setPointSize(11);
+            const int size = QFontMetrics(font).height();
+
+            QPixmap pixmap(QSize(size, size) * devicePixelRatio);
+            pixmap.setDevicePixelRatio(devicePixelRatio);
+            pixmap.fill(Qt::transparent);
+
+            QPainter painter(&pixmap);
+            painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+            painter.setFont(font);
+            painter.setPen(color);
+            painter.drawText(QRect(0, 0, size, size), Qt::AlignCenter, QStringLiteral("?"));
+            painter.end();
+
+            return pixmap;
+        }
+    }
+
     ContextHelpButton::ContextHelpButton(Decoration *decoration, QObject *parent)
-        : FluentDecorationButton(KDecoration2::DecorationButtonType::ContextHelp, decoration, parent)
+        : ButtonRenderer(KDecoration2::DecorationButtonType::ContextHelp, decoration, parent)
     {
         auto *decoratedClient = decoration->client().toStrongRef().data();
         connect(decoratedClient, &KDecoration2::DecoratedClient::providesContextHelpChanged,
@@ -38,31 +61,25 @@ namespace Fluent
         setVisible(decoratedClient->providesContextHelp());
     }
 
-    void ContextHelpButton::paint(QPainter *painter, const QRect &repaintRegion)
+    void ContextHelpButton::paintGlyph(QPainter *painter, const QRectF &buttonRect)
     {
-        Q_UNUSED(repaintRegion)
-
-        const QRectF buttonRect = geometry();
-
-        painter->save();
-
-        painter->setRenderHints(QPainter::Antialiasing, true);
-
-        // Background
-        painter->setPen(Qt::NoPen);
-        painter->setBrush(backgroundColor());
-        painter->drawRect(buttonRect);
-
-        // Foreground
-        painter->setPen(foregroundColor());
-        painter->setBrush(Qt::NoBrush);
-
-        QFont font = painter->font();
-        font.setPointSize(11);
-        painter->setFont(font);
+        const QColor color = painter->pen().color();
+        const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
 
-        painter->drawText(buttonRect, Qt::AlignCenter, "?");
+        // Drawn from a pixmap, which leaves the painter's font alone and
+        // keeps the "?" out of the caption cache.
+        if (m_glyphPixmap.isNull()
+                || painter->font() != m_painterFont
+                || color != m_glyphColor
+                || devicePixelRatio != m_glyphDevicePixelRatio) {
+            m_painterFont = painter->font();
+            m_glyphColor = color;
+            m_glyphDevicePixelRatio = devicePixelRatio;
+            m_glyphPixmap = renderGlyph(m_painterFont, color, devicePixelRatio);
+        }
 
-        painter->restore();
+        QRectF glyphRect(QPointF(0, 0), m_glyphPixmap.size() / devicePixelRatio);
+        glyphRect.moveCenter(buttonRect.center());
+        painter->drawPixmap(glyphRect.toRect().topLeft(), m_glyphPixmap);
     }
 }
@@ -18,20 +18,36 @@
 #pragma once
 
 // own
-#include "FluentDecorationButton.h"
+#include "ButtonRenderer.h"
 
 // KDecoration
 #include <KDecoration2/DecorationButton>
 
+// Qt
+#include <QColor>
+#include <QFont>
+#include <QPixmap>
+
 namespace Fluent
 {
-    class ContextHelpButton : public FluentDecorationButton
+    class ContextHelpButton : public ButtonRenderer<ContextHelpButton>
     {
     Q_OBJECT
 
     public:
         ContextHelpButton(Decoration *decoration, QObject *parent = nullptr);
 
-        void paint(QPainter *painter, const QRect &repaintRegion) override;
+    private:
+        static constexpr bool Antialiased = true;
+        void paintGlyph(QPainter *painter, const QRectF &buttonRect);
+
+        // The "?" as last painted. It is only rendered again when the
+        // painter's font, the color or the scale changed.
+        QPixmap m_glyphPixmap;
+        QFont m_painterFont;
+        QColor m_glyphColor;
+        qreal m_glyphDevicePixelRatio = 0;
+
+        friend class ButtonRenderer<ContextHelpButton>;
     };
 }
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "Corners.h"
+#include "PainterState.h"
+
+// Qt
+#include <QHash>
+#include <QPaintDevice>
+
+// std
+#include <cmath>
+
+namespace Fluent
+{
+    namespace Corners
+    {
+        namespace
+        {
+            struct MaskKey
+            {
+                int radius;
+                qreal devicePixelRatio;
+
+                bool operator==(const MaskKey &other) const
+                {
+                    return radius == other.radius
+                           && qFuzzyCompare(devicePixelRatio, other.devicePixelRatio);
+                }
+            };
+
+            uint qHash(const MaskKey &key, uint seed = 0)
+            {
+                return ::qHash(key.radius, seed) ^ ::qHash(qRound(key.devicePixelRatio * 100), seed);
+            }
+
+            Masks renderMasks(int radius, qreal devicePixelRatio)
+            {
+                const int size = std::ceil(radius * devicePixelRatio);
+
+                QImage topLeft(size, size, QImage::Format_ARGB32_Premultiplied);
+                topLeft.setDevicePixelRatio(devicePixelRatio);
+                topLeft.fill(Qt::black);
+
+                QPainter painter(&topLeft);
+                painter.setRenderHint(QPainter::Antialiasing);
+                painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
+                painter.setPen(Qt::NoPen);
+                painter.setBrush(Qt::black);
+                painter.drawEllipse(QRectF(0, 0, 2 * radius, 2 * radius));
+                painter.end();
+
+                QImage topRight = topLeft.mirrored(true, false);
+                topRight.setDevicePixelRatio(devicePixelRatio);
+
+                return { topLeft, topRight };
+            }
+        }
+
+        const Masks &masks(int radius, qreal devicePixelRatio)
+        {
+            static QHash<MaskKey, Masks> s_masks;
+
+            const MaskKey key { radius, devicePixelRatio };
+            auto it = s_masks.find(key);
+            if (it == s_masks.end()) {
+                it = s_masks.insert(key, renderMasks(radius, devicePixelRatio));
+            }
+
+            return *it;
+        }
+
+        void clipTopCorners(QPainter *painter, const QRect &rect, int radius)
+        {
+            if (radius <= 0) {
+                return;
+            }
+
+            const Masks &cornerMasks = masks(radius, painter->device()->devicePixelRatioF());
+
+            const PainterStyleGuard guard(painter);
+            painter->setCompositionMode(QPainter::CompositionMode_DestinationOut);
+            painter->drawImage(rect.topLeft(), cornerMasks.topLeft);
+            painter->drawImage(QPoint(rect.x() + rect.width() - radius, rect.y()), cornerMasks.topRight);
+        }
+
+        QPainterPath roundedTopPath(const QRectF &rect, int radius)
+        {
+            QPainterPath path;
+            if (radius <= 0) {
+                path.addRect(rect);
+                return path;
+            }
+
+            const qreal diameter = 2 * radius;
+            path.moveTo(rect.bottomLeft());
+            path.lineTo(rect.left(), rect.top() + radius);
+            path.arcTo(QRectF(rect.left(), rect.top(), diameter, diameter), 180, -90);
+            path.lineTo(rect.right() - radius, rect.top());
+            path.arcTo(QRectF(rect.right() - diameter, rect.top(), diameter, diameter), 90, -90);
+            path.lineTo(rect.bottomRight());
+            path.closeSubpath();
+            return path;
+        }
+
+        QRegion roundedTopRegion(const QRect &rect, int radius)
+        {
+            if (radius <= 0) {
+                return QRegion(rect);
+            }
+
+            radius = qMin(radius, qMin(rect.width() / 2, rect.height()));
+
+            // One row per scanline of the rounded part, which keeps the
+            // region small while following the curve closely.
+            QRegion region(rect.adjusted(0, radius, 0, 0));
+            for (int y = 0; y < radius; ++y) {
+                const qreal dy = radius - y - 0.5;
+                const int inset = qRound(radius - std::sqrt(radius * radius - dy * dy));
+                region += QRect(rect.x() + inset, rect.y() + y, rect.width() - 2 * inset, 1);
+            }
+
+            return region;
+        }
+    }
+}
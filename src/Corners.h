@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QImage>
+#include <QPainter>
+#include <QPainterPath>
+#include <QRect>
+#include <QRegion>
+
+namespace Fluent
+{
+    namespace Corners
+    {
+        struct Masks
+        {
+            QImage topLeft;
+            QImage topRight;
+        };
+
+        // Antialiased masks that cover everything outside a quarter circle
+        // of the given radius. They are rendered once per radius and device
+        // pixel ratio and shared by all decorations.
+        const Masks &masks(int radius, qreal devicePixelRatio);
+
+        // Cuts the top corners of the given rect out of whatever has been
+        // painted so far.
+        void clipTopCorners(QPainter *painter, const QRect &rect, int radius);
+
+        // The given rect with its top corners rounded.
+        QPainterPath roundedTopPath(const QRectF &rect, int radius);
+        QRegion roundedTopRegion(const QRect &rect, int radius);
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "DebugHud.h"
+#include "CaptionCache.h"
+#include "Decoration.h"
+
+// Qt
+#include <QFont>
+
+namespace Fluent
+{
+    void DebugHud::addRepaint(Cause cause)
+    {
+        ++m_repaints[int(cause)];
+    }
+
+    void DebugHud::beginPaint()
+    {
+        m_paintTimer.start();
+    }
+
+    void DebugHud::endPaint()
+    {
+        m_lastPaintNs = m_paintTimer.nsecsElapsed();
+        m_totalPaintNs += m_lastPaintNs;
+        ++m_paintCount;
+    }
+
+    void DebugHud::paint(QPainter *painter, const QRect &rect) const
+    {
+        const CaptionCache::Stats captionStats = CaptionCache::stats();
+        const qreal averagePaintUs = m_paintCount ? m_totalPaintNs / 1000.0 / m_paintCount : 0;
+
+        const QString firstLine = QStringLiteral("paint %1 / avg %2 us  shadows %3  captions %4%")
+                .arg(m_lastPaintNs / 1000.0, 0, 'f', 0)
+                .arg(averagePaintUs, 0, 'f', 0)
+                .arg(Decoration::cachedShadowCount())
+                .arg(captionStats.hitRate() * 100, 0, 'f', 0);
+        const QString secondLine = QStringLiteral("repaints cap %1 act %2 lay %3 cfg %4")
+                .arg(m_repaints[int(Cause::Caption)])
+                .arg(m_repaints[int(Cause::Active)])
+                .arg(m_repaints[int(Cause::Layout)])
+                .arg(m_repaints[int(Cause::Config)]);
+
+        QFont font = painter->font();
+        font.setPixelSize(qMax(6, rect.height() / 2 - 2));
+
+        painter->save();
+        painter->setFont(font);
+
+        const QFontMetrics metrics(font);
+        const int width = qMax(metrics.horizontalAdvance(firstLine), metrics.horizontalAdvance(secondLine)) + 8;
+        const QRect hudRect(rect.right() - width + 1, rect.top(), width, rect.height());
+
+        painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+        painter->fillRect(hudRect, QColor(0, 0, 0, 200));
+        painter->setPen(QColor(0, 255, 0));
+        painter->drawText(hudRect.adjusted(4, 0, -4, -rect.height() / 2), Qt::AlignLeft | Qt::AlignVCenter, firstLine);
+        painter->drawText(hudRect.adjusted(4, rect.height() / 2, -4, 0), Qt::AlignLeft | Qt::AlignVCenter, secondLine);
+
+        painter->restore();
+    }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QRect>
+
+// std
+#include <array>
+
+namespace Fluent
+{
+    // Small overlay in the title bar with the decoration's own costs, for
+    // looking into stutter reports. A decoration only has one while the
+    // HUD is enabled, so it costs nothing otherwise.
+    class DebugHud
+    {
+    public:
+        enum class Cause {
+            Caption,
+            Active,
+            Layout,
+            Config,
+            CauseCount
+        };
+
+        void addRepaint(Cause cause);
+
+        void beginPaint();
+        void endPaint();
+
+        void paint(QPainter *painter, const QRect &rect) const;
+
+    private:
+        std::array<int, int(Cause::CauseCount)> m_repaints {};
+
+        QElapsedTimer m_paintTimer;
+        qint64 m_lastPaintNs = 0;
+        qint64 m_totalPaintNs = 0;
+        int m_paintCount = 0;
+    };
+}
@@ -17,12 +17,20 @@
 
 // own
 #include "Decoration.h"
+#include "AcrylicNoise.h"
+#include "BakedShadows.h"
 #include "BoxShadowHelper.h"
+#include "CaptionCache.h"
 #include "CloseButton.h"
+#include "DebugHud.h"
+#include "EventRecorder.h"
 #include "MaximizeButton.h"
 #include "MinimizeButton.h"
 #include "ContextHelpButton.h"
+#include "Corners.h"
 #include "MenuButton.h"
+#include "Trace.h"
+#include "WindowVisibility.h"
 
 // KDecoration
 #include <KDecoration2/DecoratedClient>
@@ -30,27 +38,25 @@
 #include <KDecoration2/DecorationShadow>
 
 // Qt
+#include <QGuiApplication>
+#include <QHash>
 #include <QPainter>
+#include <QScopedValueRollback>
+#include <QScreen>
 #include <QSharedPointer>
 #include <QTimer>
+#include <QtMath>
+
+// std
+#include <algorithm>
 
 namespace Fluent
 {
-    namespace
-    {
-        const CompositeShadowParams s_shadowParams = CompositeShadowParams(
-                QPoint(0, 12),
-                ShadowParams(QPoint(0, 0), 48, 0.8),
-                ShadowParams(QPoint(0, -6), 24, 0.2));
-    }
-
     static int s_decoCount = 0;
-    static QColor s_shadowColor(0, 0, 0);
-    static QSharedPointer<KDecoration2::DecorationShadow> s_cachedShadow;
-    static QSharedPointer<KDecoration2::DecorationShadow> s_cachedShadowInactive;
-
-    static qreal s_titleBarOpacityActive = 0.8;
-    static qreal s_titleBarOpacityInactive = 0.8;
+    // Shared shadows, keyed by shadowCacheKey().
+    static QHash<int, QSharedPointer<KDecoration2::DecorationShadow>> s_cachedShadows;
+    static int s_cachedShadowRevision = 0;
+    static int s_shadowGenerationCount = 0;
 
     Decoration::Decoration(QObject *parent, const QVariantList &args)
             : KDecoration2::Decoration(parent, args)
@@ -60,68 +66,378 @@ namespace Fluent
 
     Decoration::~Decoration()
     {
+        if (Q_UNLIKELY(EventRecorder::isEnabled())) {
+            EventRecorder::detach(this);
+        }
+
         if (--s_decoCount == 0) {
-            s_cachedShadow.clear();
+            s_cachedShadows.clear();
         }
     }
 
     void Decoration::paint(QPainter *painter, const QRect &repaintRegion)
     {
-        auto *decoratedClient = client().toStrongRef().data();
+        // The window is about to be shown, so whatever init() deferred
+        // can't wait any longer.
+        if (Q_UNLIKELY(!m_initialized)) {
+            m_painting = true;
+            finishInit();
+            m_painting = false;
+        }
+
+        // KWin paints hidden windows too every now and then, e.g. for
+        // thumbnails. Caption and colors are read right here anyway, so
+        // only the HUD has to catch up. Everything that talks to KWin
+        // waits for refresh(), the window stays dirty until then.
+        if (Q_UNLIKELY(m_dirty)) {
+            syncDebugHud();
+        }
+
+        if (Q_UNLIKELY(m_hud)) {
+            m_hud->beginPaint();
+        }
+
+        {
+            FLUENT_TRACE_SCOPE("paint", this);
+
+            auto *decoratedClient = client().toStrongRef().data();
+
+            if (!decoratedClient->isShaded()) {
+                paintFrameBackground(painter, repaintRegion);
+            }
+
+            paintTitleBarBackground(painter, repaintRegion);
+            paintCaption(painter, repaintRegion);
+            paintButtons(painter, repaintRegion);
+            paintCorners(painter, repaintRegion);
+        }
+
+        if (Q_UNLIKELY(m_hud)) {
+            m_hud->endPaint();
+            m_hud->paint(painter, captionRect());
+        }
 
-        if (!decoratedClient->isShaded()) {
-            paintFrameBackground(painter, repaintRegion);
+        if (Q_UNLIKELY(m_timeToFirstFrame < 0)) {
+            m_timeToFirstFrame = m_initTimer.nsecsElapsed() / 1000;
+
+            if (Trace::isEnabled()) {
+                const qint64 end = Trace::now();
+                Trace::complete("timeToFirstFrame", end - m_timeToFirstFrame, end, this);
+            }
+        }
+    }
+
+    bool Decoration::event(QEvent *event)
+    {
+        if (Q_UNLIKELY(EventRecorder::isEnabled())) {
+            EventRecorder::recordInput(this, event);
         }
 
-        paintTitleBarBackground(painter, repaintRegion);
-        paintCaption(painter, repaintRegion);
-        paintButtons(painter, repaintRegion);
+        return KDecoration2::Decoration::event(event);
+    }
+
+    qint64 Decoration::timeToFirstFrame() const
+    {
+        return m_timeToFirstFrame;
     }
 
     void Decoration::init()
     {
+        FLUENT_TRACE_SCOPE("init", this);
+
+        m_initTimer.start();
+
+        if (Q_UNLIKELY(EventRecorder::isEnabled())) {
+            EventRecorder::attach(this);
+        }
+
+        // Only the geometry KWin needs to map the window is set up right
+        // away. Everything else is done by finishInit(), either when the
+        // event loop gets idle or right before the first paint, whichever
+        // comes first. This keeps bursts of mapped windows (e.g. when a
+        // session is restored) from stalling on work nobody sees yet.
         auto *decoratedClient = client().toStrongRef().data();
 
         connect(decoratedClient, &KDecoration2::DecoratedClient::widthChanged,
                 this, &Decoration::updateTitleBar);
+
+        updateBorders();
+        updateResizeBorders();
+        updateTitleBar();
+
+        // Maximized windows lose their rounded corners.
+        connect(decoratedClient, &KDecoration2::DecoratedClient::maximizedChanged,
+                this, &Decoration::updateOpaque);
+        updateOpaque();
+
+        // Only the translucent title bar needs the blur behind it. Keep the
+        // region as small as possible and only touch it when its shape can
+        // actually change.
+        connect(this, &KDecoration2::Decoration::titleBarChanged,
+                this, &Decoration::updateBlurRegion);
+        connect(decoratedClient, &KDecoration2::DecoratedClient::shadedChanged,
+                this, &Decoration::updateBlurRegion);
+        connect(decoratedClient, &KDecoration2::DecoratedClient::maximizedChanged,
+                this, &Decoration::updateBlurRegion);
+        updateBlurRegion();
+
+        auto s = settings();
+        connect(s.data(), &KDecoration2::DecorationSettings::borderSizeChanged, this, &Decoration::updateBorders);
+        connect(s.data(), &KDecoration2::DecorationSettings::fontChanged, this, &Decoration::updateBorders);
+        connect(s.data(), &KDecoration2::DecorationSettings::spacingChanged, this, &Decoration::updateBorders);
+
+        // Font, spacing and border changes come with their own signals, so
+        // "reconfigured" only needs to pick up our own configuration.
+        ThemeConfig::self()->watch(s);
+
+        QTimer::singleShot(0, this, &Decoration::finishInit);
+    }
+
+    void Decoration::finishInit()
+    {
+        if (m_initialized) {
+            return;
+        }
+        m_initialized = true;
+
+        FLUENT_TRACE_SCOPE("finishInit", this);
+
+        auto *decoratedClient = client().toStrongRef().data();
+
         connect(decoratedClient, &KDecoration2::DecoratedClient::widthChanged,
                 this, &Decoration::updateButtonsGeometry);
         connect(decoratedClient, &KDecoration2::DecoratedClient::maximizedChanged,
                 this, &Decoration::updateButtonsGeometry);
 
-        auto repaintTitleBar = [this] {
-            update(titleBar());
+        m_captionTimer.setSingleShot(true);
+        connect(&m_captionTimer, &QTimer::timeout, this,
+                [this] {
+                    // Paint the latest caption and keep throttling, or go
+                    // back to repainting right away if nothing happened.
+                    if (m_captionPending) {
+                        m_captionPending = false;
+                        if (deferWhileHidden()) {
+                            return;
+                        }
+                        repaintCaption();
+                        m_captionTimer.start(captionRepaintInterval());
+                    }
+                });
+
+        auto onShadowStateChanged = [this] {
+            if (!deferWhileHidden()) {
+                updateShadow();
+            }
         };
+        connect(decoratedClient, &KDecoration2::DecoratedClient::maximizedChanged,
+                this, onShadowStateChanged);
+        connect(decoratedClient, &KDecoration2::DecoratedClient::adjacentScreenEdgesChanged,
+                this, onShadowStateChanged);
 
+        // Both title bar colors depend on the active state, so this one
+        // really has to repaint the whole title bar.
         auto onActiveChanged = [this] {
+            FLUENT_TRACE_INSTANT("activeChanged", this);
+            if (deferWhileHidden()) {
+                return;
+            }
+            if (m_hud) {
+                m_hud->addRepaint(DebugHud::Cause::Active);
+            }
             update(titleBar());
             updateShadow();
         };
 
+        // Report activation first, so the window already counts as
+        // visible when onActiveChanged() runs.
+        WindowVisibility *visibility = WindowVisibility::self();
+        auto reportActivation = [visibility, decoratedClient] {
+            if (decoratedClient->isActive()) {
+                visibility->windowActivated(decoratedClient->desktop(), decoratedClient->isOnAllDesktops());
+            }
+        };
+        connect(decoratedClient, &KDecoration2::DecoratedClient::activeChanged,
+                this, reportActivation);
+        reportActivation();
+
         connect(decoratedClient, &KDecoration2::DecoratedClient::captionChanged,
-                this, repaintTitleBar);
+                this, &Decoration::onCaptionChanged);
         connect(decoratedClient, &KDecoration2::DecoratedClient::activeChanged,
                 this, onActiveChanged);
-
-        updateBorders();
-        updateResizeBorders();
-        updateTitleBar();
+        connect(decoratedClient, &KDecoration2::DecoratedClient::paletteChanged, this,
+                [this] {
+                    if (!deferWhileHidden()) {
+                        update();
+                    }
+                });
+
+        // Hidden means on another virtual desktop.
+        connect(decoratedClient, &KDecoration2::DecoratedClient::desktopChanged,
+                this, &Decoration::updateVisibility);
+        connect(decoratedClient, &KDecoration2::DecoratedClient::onAllDesktopsChanged,
+                this, &Decoration::updateVisibility);
+        connect(visibility, &WindowVisibility::currentDesktopChanged,
+                this, &Decoration::updateVisibility);
+        updateVisibility();
 
         auto s = settings();
-        connect(s.data(), &KDecoration2::DecorationSettings::borderSizeChanged, this, &Decoration::updateBorders);
-        connect(s.data(), &KDecoration2::DecorationSettings::fontChanged, this, &Decoration::updateBorders);
-        connect(s.data(), &KDecoration2::DecorationSettings::spacingChanged, this, &Decoration::updateBorders);
-        connect(s.data(), &KDecoration2::DecorationSettings::reconfigured, this, &Decoration::updateBorders);
-
         connect(s.data(), &KDecoration2::DecorationSettings::spacingChanged, this, &Decoration::updateButtonsGeometryDelayed);
         connect(s.data(), &KDecoration2::DecorationSettings::decorationButtonsLeftChanged, this, &Decoration::updateButtonsGeometryDelayed);
         connect(s.data(), &KDecoration2::DecorationSettings::decorationButtonsRightChanged, this, &Decoration::updateButtonsGeometryDelayed);
-        connect(s.data(), &KDecoration2::DecorationSettings::reconfigured, this, &Decoration::updateButtonsGeometryDelayed);
 
+        connect(ThemeConfig::self(), &ThemeConfig::changed, this, &Decoration::onThemeConfigChanged);
+
+        // Buttons that are hidden anyway are not created until the client
+        // says they are needed, see materializeButton().
+        connect(decoratedClient, &KDecoration2::DecoratedClient::closeableChanged, this,
+                [this] (bool closeable) {
+                    if (closeable) {
+                        materializeButton(KDecoration2::DecorationButtonType::Close);
+                    }
+                });
+        connect(decoratedClient, &KDecoration2::DecoratedClient::maximizeableChanged, this,
+                [this] (bool maximizeable) {
+                    if (maximizeable) {
+                        materializeButton(KDecoration2::DecorationButtonType::Maximize);
+                    }
+                });
+        connect(decoratedClient, &KDecoration2::DecoratedClient::minimizeableChanged, this,
+                [this] (bool minimizeable) {
+                    if (minimizeable) {
+                        materializeButton(KDecoration2::DecorationButtonType::Minimize);
+                    }
+                });
+        connect(decoratedClient, &KDecoration2::DecoratedClient::providesContextHelpChanged, this,
+                [this] (bool providesContextHelp) {
+                    if (providesContextHelp) {
+                        materializeButton(KDecoration2::DecorationButtonType::ContextHelp);
+                    }
+                });
+
+        m_leftButtons = createButtonGroup(KDecoration2::DecorationButtonGroup::Position::Left);
+        m_rightButtons = createButtonGroup(KDecoration2::DecorationButtonGroup::Position::Right);
+
+        updateButtonsGeometry();
+
+        // For some reason, the shadow should be installed the last. Otherwise,
+        // the Window Decorations KCM crashes.
+        if (m_painting) {
+            // Called from the first paint, which draws everything anyway.
+            // Don't schedule repaints from inside it, and install the
+            // shadow once the paint is done.
+            syncDebugHud();
+            QTimer::singleShot(0, this, &Decoration::updateShadow);
+        } else {
+            updateDebugHud();
+            updateShadow();
+        }
+    }
+
+    void Decoration::onThemeConfigChanged(ThemeConfig::Changes changes)
+    {
+        if (deferWhileHidden()) {
+            return;
+        }
+
+        if (changes & ThemeConfig::ShadowChanged) {
+            updateShadow();
+        }
+
+        if (changes & ThemeConfig::DebugHudChanged) {
+            updateDebugHud();
+        }
+
+        if (changes & ThemeConfig::TitleBarChanged) {
+            if (m_hud) {
+                m_hud->addRepaint(DebugHud::Cause::Config);
+            }
+            updateOpaque();
+            updateBlurRegion();
+            update(titleBar());
+        }
+    }
+
+    void Decoration::updateDebugHud()
+    {
+        if (syncDebugHud()) {
+            update(titleBar());
+        }
+    }
+
+    bool Decoration::syncDebugHud()
+    {
+        if (ThemeConfig::self()->debugHud() == bool(m_hud)) {
+            return false;
+        }
+
+        if (ThemeConfig::self()->debugHud()) {
+            m_hud.reset(new DebugHud());
+        } else {
+            m_hud.reset();
+        }
+
+        return true;
+    }
+
+    void Decoration::updateVisibility()
+    {
+        const auto *decoratedClient = client().toStrongRef().data();
+        const int currentDesktop = WindowVisibility::self()->currentDesktop();
+
+        const bool hidden = currentDesktop != 0
+                            && !decoratedClient->isOnAllDesktops()
+                            && decoratedClient->desktop() != currentDesktop;
+
+        if (hidden == m_hidden) {
+            return;
+        }
+
+        m_hidden = hidden;
+
+        if (!m_hidden && m_dirty) {
+            refresh();
+        }
+    }
+
+    bool Decoration::deferWhileHidden()
+    {
+        if (!m_hidden) {
+            return false;
+        }
+
+        m_dirty = true;
+        return true;
+    }
+
+    void Decoration::refresh()
+    {
+        FLUENT_TRACE_SCOPE("refresh", this);
+
+        // Whatever was put off, redoing all of it is cheap compared to
+        // doing each piece every time it changed.
+        m_dirty = false;
+
+        updateOpaque();
+        updateBlurRegion();
+        updateDebugHud();
+        updateShadow();
+
+        if (m_hud) {
+            m_hud->addRepaint(DebugHud::Cause::Config);
+        }
+        update();
+    }
+
+    KDecoration2::DecorationButtonGroup *Decoration::createButtonGroup(KDecoration2::DecorationButtonGroup::Position position)
+    {
         auto buttonCreator = [this] (KDecoration2::DecorationButtonType type, KDecoration2::Decoration *decoration, QObject *parent)
                 -> KDecoration2::DecorationButton* {
             Q_UNUSED(decoration)
 
+            if (!isButtonNeeded(type)) {
+                return nullptr;
+            }
+
             switch (type) {
                 case KDecoration2::DecorationButtonType::Close:
                     return new CloseButton(this, parent);
@@ -143,25 +459,74 @@ namespace Fluent
             }
         };
 
-        m_leftButtons = new KDecoration2::DecorationButtonGroup(
-                KDecoration2::DecorationButtonGroup::Position::Left,
-                this,
-                buttonCreator);
+        auto *group = new KDecoration2::DecorationButtonGroup(position, this, buttonCreator);
+
+        // The group relayouts itself when a button is shown or hidden, and
+        // recreates its buttons when the button layout is edited. Follow
+        // the group rather than the buttons, so neither goes unnoticed.
+        connect(group, &KDecoration2::DecorationButtonGroup::geometryChanged,
+                this, &Decoration::updateButtonsGeometry);
 
-        m_rightButtons = new KDecoration2::DecorationButtonGroup(
-                KDecoration2::DecorationButtonGroup::Position::Right,
-                this,
-                buttonCreator);
+        return group;
+    }
 
-        updateButtonsGeometry();
+    bool Decoration::isButtonNeeded(KDecoration2::DecorationButtonType type) const
+    {
+        const auto *decoratedClient = client().toStrongRef().data();
 
-        // For some reason, the shadow should be installed the last. Otherwise,
-        // the Window Decorations KCM crashes.
-        updateShadow();
+        switch (type) {
+            case KDecoration2::DecorationButtonType::Close:
+                return decoratedClient->isCloseable();
+
+            case KDecoration2::DecorationButtonType::Maximize:
+                return decoratedClient->isMaximizeable();
+
+            case KDecoration2::DecorationButtonType::Minimize:
+                return decoratedClient->isMinimizeable();
+
+            case KDecoration2::DecorationButtonType::ContextHelp:
+                return decoratedClient->providesContextHelp();
+
+            default:
+                return true;
+        }
+    }
+
+    void Decoration::materializeButton(KDecoration2::DecorationButtonType type)
+    {
+        auto hasButton = [type] (const KDecoration2::DecorationButtonGroup *group) {
+            const auto buttons = group->buttons();
+            return std::any_of(buttons.begin(), buttons.end(),
+                    [type] (const QPointer<KDecoration2::DecorationButton> &button) {
+                        return button && button->type() == type;
+                    });
+        };
+
+        // Once created, a button stays around and hides itself, so this
+        // only does work the first time the button becomes visible.
+        bool changed = false;
+
+        if (settings()->decorationButtonsLeft().contains(type) && !hasButton(m_leftButtons)) {
+            delete m_leftButtons;
+            m_leftButtons = createButtonGroup(KDecoration2::DecorationButtonGroup::Position::Left);
+            changed = true;
+        }
+
+        if (settings()->decorationButtonsRight().contains(type) && !hasButton(m_rightButtons)) {
+            delete m_rightButtons;
+            m_rightButtons = createButtonGroup(KDecoration2::DecorationButtonGroup::Position::Right);
+            changed = true;
+        }
+
+        if (changed) {
+            updateButtonsGeometry();
+        }
     }
 
     void Decoration::updateBorders()
     {
+        FLUENT_TRACE_SCOPE("updateBorders", this);
+
         QMargins borders;
         borders.setTop(titleBarHeight());
         setBorders(borders);
@@ -182,12 +547,58 @@ namespace Fluent
 
     void Decoration::updateTitleBar()
     {
+        FLUENT_TRACE_SCOPE("updateTitleBar", this);
+
         auto *decoratedClient = client().toStrongRef().data();
         setTitleBar(QRect(0, 0, decoratedClient->width(), titleBarHeight()));
     }
 
+    void Decoration::updateOpaque()
+    {
+        // The frame is painted with an opaque palette color, so the title
+        // bar decides whether the compositor has to blend the decoration.
+        // Rounded corners are cut out of it and always need blending.
+        setOpaque(ThemeConfig::self()->opaqueTitleBar() && cornerRadius() == 0);
+    }
+
+    void Decoration::updateBlurRegion()
+    {
+        QRegion region;
+        if (!ThemeConfig::self()->opaqueTitleBar()) {
+            region = titleBarShape();
+        }
+
+        if (region != m_blurRegion) {
+            m_blurRegion = region;
+            setBlurRegion(region);
+        }
+    }
+
+    QRegion Decoration::titleBarShape() const
+    {
+        return Corners::roundedTopRegion(titleBar(), cornerRadius());
+    }
+
+    int Decoration::cornerRadius() const
+    {
+        const auto *decoratedClient = client().toStrongRef().data();
+        if (decoratedClient->isMaximized()) {
+            return 0;
+        }
+
+        return ThemeConfig::self()->cornerRadius();
+    }
+
     void Decoration::updateButtonsGeometry()
     {
+        // Moving the groups below changes their geometry again.
+        if (m_updatingButtonsGeometry) {
+            return;
+        }
+        const QScopedValueRollback<bool> updating(m_updatingButtonsGeometry, true);
+
+        FLUENT_TRACE_SCOPE("updateButtonsGeometry", this);
+
         if (!m_leftButtons->buttons().isEmpty()) {
             m_leftButtons->setPos(QPointF(0, 0));
             m_leftButtons->setSpacing(0);
@@ -198,7 +609,39 @@ namespace Fluent
             m_rightButtons->setSpacing(0);
         }
 
-        update();
+        const Layout layout {
+            m_leftButtons->geometry().toAlignedRect(),
+            m_rightButtons->geometry().toAlignedRect(),
+            captionRect()
+        };
+
+        // Damage the old and the new place of whatever moved. Buttons that
+        // only changed their own state repaint themselves.
+        QRegion damage;
+        auto addDamage = [&damage] (const QRect &before, const QRect &after) {
+            if (before != after) {
+                damage += before;
+                damage += after;
+            }
+        };
+        addDamage(m_layout.leftButtons, layout.leftButtons);
+        addDamage(m_layout.rightButtons, layout.rightButtons);
+        addDamage(m_layout.caption, layout.caption);
+
+        m_layout = layout;
+
+        // The first paint lays the buttons out while it paints all of them.
+        if (m_painting) {
+            return;
+        }
+
+        if (m_hud && !damage.isEmpty()) {
+            m_hud->addRepaint(DebugHud::Cause::Layout);
+        }
+
+        for (const QRect &rect : damage) {
+            update(rect);
+        }
     }
 
     void Decoration::updateButtonsGeometryDelayed()
@@ -206,19 +649,165 @@ namespace Fluent
         QTimer::singleShot(0, this, &Decoration::updateButtonsGeometry);
     }
 
+    QRect Decoration::captionRect() const
+    {
+        const QRect titleBarRect(0, 0, size().width(), titleBarHeight());
+
+        return titleBarRect.adjusted(
+                m_leftButtons->geometry().width() + settings()->smallSpacing(), 0,
+                -(m_rightButtons->geometry().width() + settings()->smallSpacing()), 0
+        );
+    }
+
+    void Decoration::onCaptionChanged()
+    {
+        FLUENT_TRACE_INSTANT("captionChanged", this);
+        if (deferWhileHidden()) {
+            return;
+        }
+
+        if (m_captionTimer.isActive()) {
+            m_captionPending = true;
+            return;
+        }
+
+        repaintCaption();
+        m_captionTimer.start(captionRepaintInterval());
+    }
+
+    void Decoration::repaintCaption()
+    {
+        if (m_hud) {
+            m_hud->addRepaint(DebugHud::Cause::Caption);
+        }
+        update(captionRect());
+    }
+
+    int Decoration::captionRepaintInterval() const
+    {
+        int rate = ThemeConfig::self()->maxCaptionRate();
+        if (rate <= 0) {
+            const QScreen *screen = QGuiApplication::primaryScreen();
+            rate = screen ? qRound(screen->refreshRate()) : 60;
+        }
+
+        return qCeil(1000.0 / qMax(1, rate));
+    }
+
+    static int shadowCacheKey(bool active, Qt::Edges edges)
+    {
+        return (active ? 1 : 0) | (int(edges) << 1);
+    }
+
     void Decoration::updateShadow()
     {
+        FLUENT_TRACE_SCOPE("updateShadow", this);
+
         const auto *decoratedClient = client().toStrongRef().data();
+
+        // A maximized window has nowhere to cast its shadow.
+        if (decoratedClient->isMaximized()) {
+            setShadow(QSharedPointer<KDecoration2::DecorationShadow>());
+            return;
+        }
+
         auto isActive = decoratedClient->isActive();
 
-        auto &shadow = isActive ? s_cachedShadow : s_cachedShadowInactive;
+        // Edges that touch a screen border (e.g. of quick-tiled windows)
+        // don't get any shadow, it would only end up off-screen or under
+        // a panel.
+        const Qt::Edges edges = decoratedClient->adjacentScreenEdges();
+
+        // The first decoration to notice a configuration change regenerates
+        // the shadow, all the others pick up the shared result.
+        const ThemeConfig *config = ThemeConfig::self();
+        if (s_cachedShadowRevision != config->shadowRevision()) {
+            s_cachedShadows.clear();
+            s_cachedShadowRevision = config->shadowRevision();
+        }
+
+        const int key = shadowCacheKey(isActive, edges);
+        QSharedPointer<KDecoration2::DecorationShadow> shadow = s_cachedShadows.value(key);
         if (shadow.isNull()) {
-            shadow = createShadow(s_shadowParams, isActive ? 1.0 : 0.5);
+            const int fullKey = shadowCacheKey(isActive, Qt::Edges());
+            QSharedPointer<KDecoration2::DecorationShadow> fullShadow = s_cachedShadows.value(fullKey);
+            if (fullShadow.isNull()) {
+                // Active and inactive shadows only differ in strength, so
+                // they are generated and published together. The other
+                // one is going to be needed as soon as focus moves.
+                QVector<QSharedPointer<KDecoration2::DecorationShadow>> family;
+
+                // The default shadows were rendered at build time already.
+                if (config->hasDefaultShadow()) {
+                    const QImage active = BakedShadows::image(true);
+                    const QImage inactive = BakedShadows::image(false);
+                    if (!active.isNull() && !inactive.isNull()) {
+                        const QMargins padding = shadowPadding(config->shadowParams(), config->shadowBlurSettings());
+                        family = { wrapShadow(active, padding), wrapShadow(inactive, padding) };
+                    }
+                }
+
+                if (family.isEmpty()) {
+                    family = createShadows(config->shadowParams(), config->shadowColor(), config->cornerRadius(),
+                                           config->shadowBlurSettings(), { 1.0, 0.5 });
+                }
+                s_cachedShadows.insert(shadowCacheKey(true, Qt::Edges()), family.at(0));
+                s_cachedShadows.insert(shadowCacheKey(false, Qt::Edges()), family.at(1));
+                fullShadow = family.at(isActive ? 0 : 1);
+            }
+
+            shadow = edges ? withoutEdges(fullShadow, edges) : fullShadow;
+            s_cachedShadows.insert(key, shadow);
         }
 
         setShadow(shadow);
     }
 
+    QSharedPointer<KDecoration2::DecorationShadow> Decoration::withoutEdges(
+            const QSharedPointer<KDecoration2::DecorationShadow> &shadow, Qt::Edges edges)
+    {
+        const QImage image = shadow->shadow();
+        const QRect innerRect = shadow->innerShadowRect();
+        QMargins padding = shadow->padding();
+
+        // Drop the tiles of the covered edges from the texture as well,
+        // instead of just squashing them.
+        QRect cropRect = image.rect();
+        if (edges & Qt::LeftEdge) {
+            cropRect.setLeft(innerRect.left());
+            padding.setLeft(0);
+        }
+        if (edges & Qt::TopEdge) {
+            cropRect.setTop(innerRect.top());
+            padding.setTop(0);
+        }
+        if (edges & Qt::RightEdge) {
+            cropRect.setRight(innerRect.right());
+            padding.setRight(0);
+        }
+        if (edges & Qt::BottomEdge) {
+            cropRect.setBottom(innerRect.bottom());
+            padding.setBottom(0);
+        }
+
+        auto decorationShadow = QSharedPointer<KDecoration2::DecorationShadow>::create();
+        decorationShadow->setPadding(padding);
+        decorationShadow->setInnerShadowRect(innerRect.translated(-cropRect.topLeft()));
+        decorationShadow->setShadow(image.copy(cropRect));
+
+        return decorationShadow;
+    }
+
+    int Decoration::cachedShadowCount()
+    {
+        return s_cachedShadows.size();
+    }
+
+    int Decoration::shadowGenerationCount()
+    {
+        return s_shadowGenerationCount;
+    }
+
     int Decoration::titleBarHeight() const
     {
         const QFontMetrics fontMetrics(settings()->font());
@@ -229,23 +818,24 @@ namespace Fluent
     void Decoration::paintFrameBackground(QPainter *painter, const QRect &repaintRegion) const
     {
         Q_UNUSED(repaintRegion)
+        FLUENT_TRACE_SCOPE("paintFrameBackground", this);
 
         const auto *decoratedClient = client().toStrongRef().data();
 
-        painter->save();
+        const PainterStyleGuard guard(painter);
 
         painter->fillRect(rect(), Qt::transparent);
         painter->setRenderHint(QPainter::Antialiasing);
         painter->setPen(Qt::NoPen);
-        painter->setBrush(decoratedClient->color(
+        painter->setBrush(m_frameBrush(decoratedClient->color(
                 decoratedClient->isActive()
                 ? KDecoration2::ColorGroup::Active
                 : KDecoration2::ColorGroup::Inactive,
-                KDecoration2::ColorRole::Frame));
-        painter->setClipRect(0, borderTop(), size().width(), size().height() - borderTop(), Qt::IntersectClip);
-        painter->drawRect(rect());
+                KDecoration2::ColorRole::Frame)));
 
-        painter->restore();
+        // Only the part below the title bar. Drawn as a smaller rect rather
+        // than through a clip, which couldn't be undone without save().
+        painter->drawRect(QRect(0, borderTop(), size().width(), size().height() - borderTop()));
     }
 
     QColor Decoration::titleBarBackgroundColor() const
@@ -254,10 +844,17 @@ namespace Fluent
         const auto group = decoratedClient->isActive()
                            ? KDecoration2::ColorGroup::Active
                            : KDecoration2::ColorGroup::Inactive;
-        const qreal opacity = decoratedClient->isActive()
-                              ? s_titleBarOpacityActive
-                              : s_titleBarOpacityInactive;
         QColor color = decoratedClient->color(group, KDecoration2::ColorRole::TitleBar);
+
+        const ThemeConfig *config = ThemeConfig::self();
+        if (config->opaqueTitleBar()) {
+            color.setAlpha(255);
+            return color;
+        }
+
+        const qreal opacity = decoratedClient->isActive()
+                              ? config->titleBarOpacityActive()
+                              : config->titleBarOpacityInactive();
         color.setAlphaF(opacity);
         return color;
     }
@@ -274,110 +871,199 @@ namespace Fluent
     void Decoration::paintTitleBarBackground(QPainter *painter, const QRect &repaintRegion) const
     {
         Q_UNUSED(repaintRegion)
+        FLUENT_TRACE_SCOPE("paintTitleBarBackground", this);
 
         const auto *decoratedClient = client().toStrongRef().data();
 
-        painter->save();
-        painter->setPen(Qt::NoPen);
-        painter->setBrush(titleBarBackgroundColor());
-        painter->drawRect(QRect(0, 0, decoratedClient->width(), titleBarHeight()));
-        painter->restore();
+        const QRect titleBarRect(0, 0, decoratedClient->width(), titleBarHeight());
+        const ThemeConfig *config = ThemeConfig::self();
+
+        {
+            const PainterStyleGuard guard(painter);
+
+            if (config->opaqueTitleBar()) {
+                // Nothing to blend with, just overwrite whatever is there.
+                painter->setCompositionMode(QPainter::CompositionMode_Source);
+                painter->fillRect(titleBarRect, titleBarBackgroundColor());
+            } else {
+                painter->setPen(Qt::NoPen);
+                painter->setBrush(m_titleBarBrush(titleBarBackgroundColor()));
+                painter->drawRect(titleBarRect);
+            }
+        }
+
+        if (config->acrylicTitleBar()) {
+            AcrylicNoise::paint(painter, titleBarRect, config->acrylicNoiseOpacity());
+        }
     }
 
     void Decoration::paintCaption(QPainter *painter, const QRect &repaintRegion) const
     {
         Q_UNUSED(repaintRegion)
+        FLUENT_TRACE_SCOPE("paintCaption", this);
 
         const auto *decoratedClient = client().toStrongRef().data();
 
-        const int textWidth = settings()->fontMetrics().boundingRect(decoratedClient->caption()).width();
-        const QRect textRect((size().width() - textWidth) / 2, 0, textWidth, titleBarHeight());
+        const QRect availableRect = captionRect();
+
+        // Eliding measures the whole caption, so only redo it when the
+        // caption, the available width or the font actually changed.
+        const QString caption = decoratedClient->caption();
+        const QFont font = settings()->font();
+        if (caption != m_elidedCaption.caption
+                || availableRect.width() != m_elidedCaption.width
+                || font != m_elidedCaption.font) {
+            m_elidedCaption.caption = caption;
+            m_elidedCaption.width = availableRect.width();
+            m_elidedCaption.font = font;
+            m_elidedCaption.text = settings()->fontMetrics().elidedText(
+                    caption, Qt::ElideRight, availableRect.width());
+        }
 
-        const QRect titleBarRect(0, 0, size().width(), titleBarHeight());
+        const PainterStyleGuard guard(painter);
+        painter->setPen(m_captionPen(titleBarForegroundColor()));
+        CaptionCache::drawText(painter, availableRect, font, m_elidedCaption.text);
+    }
 
-        const QRect availableRect = titleBarRect.adjusted(
-                m_leftButtons->geometry().width() + settings()->smallSpacing(), 0,
-                -(m_rightButtons->geometry().width() + settings()->smallSpacing()), 0
-        );
+    void Decoration::paintCorners(QPainter *painter, const QRect &repaintRegion) const
+    {
+        const int radius = cornerRadius();
+        if (radius <= 0) {
+            return;
+        }
 
-        const QString caption = painter->fontMetrics().elidedText(
-                decoratedClient->caption(), Qt::ElideRight, availableRect.width());
+        const QRect titleBarRect(0, 0, size().width(), titleBarHeight());
+        if (!repaintRegion.intersects(titleBarRect.adjusted(0, 0, 0, radius - titleBarRect.height()))) {
+            return;
+        }
 
-        painter->save();
-        painter->setFont(settings()->font());
-        painter->setPen(titleBarForegroundColor());
-        painter->drawText(availableRect, Qt::AlignLeft | Qt::AlignVCenter, caption);
-        painter->restore();
+        FLUENT_TRACE_SCOPE("paintCorners", this);
+        Corners::clipTopCorners(painter, titleBarRect, radius);
     }
 
     void Decoration::paintButtons(QPainter *painter, const QRect &repaintRegion) const
     {
+        FLUENT_TRACE_SCOPE("paintButtons", this);
+
         m_leftButtons->paint(painter, repaintRegion);
         m_rightButtons->paint(painter, repaintRegion);
     }
 
-    QSharedPointer<KDecoration2::DecorationShadow> Decoration::createShadow(const CompositeShadowParams shadowParams, const qreal strength)
+    QVector<QSharedPointer<KDecoration2::DecorationShadow>> Decoration::createShadows(const CompositeShadowParams shadowParams, const QColor &color, const int cornerRadius, const BoxShadowHelper::BlurSettings &blurSettings, const QVector<qreal> &strengths)
     {
+        FLUENT_TRACE_SCOPE("createShadows", nullptr);
+        s_shadowGenerationCount += strengths.size();
+
         auto withOpacity = [] (const QColor &color, qreal opacity) -> QColor {
             QColor c(color);
             c.setAlphaF(opacity);
             return c;
         };
 
-        const int shadowSize = qMax(shadowParams.shadow1.radius, shadowParams.shadow2.radius);
+        const int shadowSize = Decoration::shadowSize(shadowParams, blurSettings);
         const QRect box(shadowSize, shadowSize, 2 * shadowSize + 1, 2 * shadowSize + 1);
         const QRect rect = box.adjusted(-shadowSize, -shadowSize, shadowSize, shadowSize);
 
-        QImage shadow(rect.size(), QImage::Format_ARGB32_Premultiplied);
-        shadow.fill(Qt::transparent);
-
-        QPainter painter(&shadow);
-        painter.setRenderHint(QPainter::Antialiasing);
-
-        // Draw the "shape" shadow.
-        BoxShadowHelper::boxShadow(
-                &painter,
-                box,
-                shadowParams.shadow1.offset,
-                shadowParams.shadow1.radius,
-                withOpacity(s_shadowColor, shadowParams.shadow1.opacity * strength));
-
-        // Draw the "contrast" shadow.
-        BoxShadowHelper::boxShadow(
-                &painter,
-                box,
-                shadowParams.shadow2.offset,
-                shadowParams.shadow2.radius,
-                withOpacity(s_shadowColor, shadowParams.shadow2.opacity * strength));
-
-        // Mask out inner rect.
-        const QMargins padding = QMargins(
-                shadowSize - shadowParams.offset.x(),
-                shadowSize - shadowParams.offset.y(),
-                shadowSize + shadowParams.offset.x(),
-                shadowSize + shadowParams.offset.y());
-        const QRect innerRect = rect - padding;
-
-        // Draw outline.
-        QPen outLine (QColor(100,100,100));
-        outLine.setWidth(2);
-        outLine.setJoinStyle(Qt::MiterJoin);
-        painter.setPen(outLine);
-        painter.setBrush(Qt::NoBrush);
-        painter.drawRect(innerRect);
-
-        painter.setPen(Qt::NoPen);
-        painter.setBrush(Qt::black);
-        painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
-        painter.drawRect(innerRect);
-
-        painter.end();
+        // The blur is the expensive part, and it's the same for every
+        // member of the family. Blur the "shape" and the "contrast" layer
+        // once, the strengths only change the opacity they are drawn with.
+        const QVector<QImage> masks = BoxShadowHelper::shadowMasks(
+                box.size(),
+                { shadowParams.shadow1.radius, shadowParams.shadow2.radius },
+                1.0,
+                blurSettings,
+                cornerRadius);
+
+        QVector<QSharedPointer<KDecoration2::DecorationShadow>> shadows;
+        shadows.reserve(strengths.size());
+
+        for (const qreal strength : strengths) {
+            QImage shadow(rect.size(), QImage::Format_ARGB32_Premultiplied);
+            shadow.fill(Qt::transparent);
+
+            QPainter painter(&shadow);
+            painter.setRenderHint(QPainter::Antialiasing);
+
+            // Draw the "shape" shadow.
+            BoxShadowHelper::drawShadowMask(
+                    &painter,
+                    box,
+                    masks.at(0),
+                    shadowParams.shadow1.offset,
+                    withOpacity(color, shadowParams.shadow1.opacity * strength));
+
+            // Draw the "contrast" shadow.
+            BoxShadowHelper::drawShadowMask(
+                    &painter,
+                    box,
+                    masks.at(1),
+                    shadowParams.shadow2.offset,
+                    withOpacity(color, shadowParams.shadow2.opacity * strength));
+
+            // Mask out inner rect.
+            const QMargins padding = shadowPadding(shadowParams, blurSettings);
+            const QRect innerRect = rect - padding;
+
+            // The cut-out follows the window's rounded top corners, so the
+            // shadow shows through where the corners are cut away.
+            const QPainterPath innerShape = Corners::roundedTopPath(innerRect, cornerRadius);
+
+            // Draw outline.
+            QPen outLine (QColor(100,100,100));
+            outLine.setWidth(2);
+            outLine.setJoinStyle(Qt::MiterJoin);
+            painter.setPen(outLine);
+            painter.setBrush(Qt::NoBrush);
+            painter.drawPath(innerShape);
+
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(Qt::black);
+            painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
+            painter.drawPath(innerShape);
+
+            painter.end();
+
+            shadows.append(wrapShadow(shadow, padding));
+        }
 
+        return shadows;
+    }
+
+    int Decoration::shadowSize(const CompositeShadowParams &shadowParams, const BoxShadowHelper::BlurSettings &blurSettings)
+    {
+        return qMax(BoxShadowHelper::shadowExtent(shadowParams.shadow1.radius, blurSettings),
+                    BoxShadowHelper::shadowExtent(shadowParams.shadow2.radius, blurSettings));
+    }
+
+    QMargins Decoration::shadowPadding(const CompositeShadowParams &shadowParams, const BoxShadowHelper::BlurSettings &blurSettings)
+    {
+        const int size = shadowSize(shadowParams, blurSettings);
+        return QMargins(
+                size - shadowParams.offset.x(),
+                size - shadowParams.offset.y(),
+                size + shadowParams.offset.x(),
+                size + shadowParams.offset.y());
+    }
+
+    QSharedPointer<KDecoration2::DecorationShadow> Decoration::wrapShadow(const QImage &image, const QMargins &padding)
+    {
         auto decorationShadow = QSharedPointer<KDecoration2::DecorationShadow>::create();
         decorationShadow->setPadding(padding);
-        decorationShadow->setInnerShadowRect(QRect(shadow.rect().center(), QSize(1, 1)));
-        decorationShadow->setShadow(shadow);
-
+        decorationShadow->setInnerShadowRect(QRect(image.rect().center(), QSize(1, 1)));
+        decorationShadow->setShadow(image);
         return decorationShadow;
     }
+
+    QVector<QImage> Decoration::renderDefaultShadows()
+    {
+        const ThemeConfig::Values &defaults = ThemeConfig::defaults();
+        const auto shadows = createShadows(defaults.shadowParams, defaults.shadowColor, defaults.cornerRadius,
+                                           defaults.shadowBlurSettings, { 1.0, 0.5 });
+
+        QVector<QImage> images;
+        for (const auto &shadow : shadows) {
+            images.append(shadow->shadow());
+        }
+        return images;
+    }
 }
@@ -17,49 +17,33 @@
 
 #pragma once
 
+// own
+#include "PainterState.h"
+#include "ThemeConfig.h"
+
 // KDecoration
 #include <KDecoration2/Decoration>
 #include <KDecoration2/DecorationButtonGroup>
 
 // Qt
+#include <QElapsedTimer>
+#include <QFont>
+#include <QImage>
+#include <QMargins>
+#include <QRegion>
+#include <QTimer>
 #include <QVariant>
+#include <QVector>
+
+// std
+#include <memory>
 
 namespace Fluent
 {
+    class DebugHud;
     class FluentDecorationButton;
     class MenuButton;
 
-    struct ShadowParams
-    {
-        ShadowParams() = default;
-
-        ShadowParams(const QPoint &offset, int radius, qreal opacity)
-                : offset(offset)
-                , radius(radius)
-                , opacity(opacity) {}
-
-        QPoint offset;
-        int radius = 0;
-        qreal opacity = 0;
-    };
-
-    struct CompositeShadowParams
-    {
-        CompositeShadowParams() = default;
-
-        CompositeShadowParams(
-                const QPoint &offset,
-                const ShadowParams &shadow1,
-                const ShadowParams &shadow2)
-                : offset(offset)
-                , shadow1(shadow1)
-                , shadow2(shadow2) {}
-
-        QPoint offset;
-        ShadowParams shadow1;
-        ShadowParams shadow2;
-    };
-
     class Decoration : public KDecoration2::Decoration
     {
     Q_OBJECT
@@ -69,31 +53,123 @@ namespace Fluent
         ~Decoration() override;
 
         void paint(QPainter *painter, const QRect &repaintRegion) override;
+        bool event(QEvent *event) override;
 
         int titleBarHeight() const;
 
+        // Microseconds from init() to the end of the first paint, or -1 if
+        // the decoration hasn't been painted yet.
+        qint64 timeToFirstFrame() const;
+
         QColor titleBarBackgroundColor() const;
         QColor titleBarForegroundColor() const;
 
+        // The active and the inactive shadow of the default configuration,
+        // for fluent-shadow-baker.
+        static QVector<QImage> renderDefaultShadows();
+
+        // Shared shadow cache introspection, used by the benchmarks.
+        static int cachedShadowCount();
+        static int shadowGenerationCount();
+
     public slots:
         void init() override;
 
     private:
+        void finishInit();
+        void onThemeConfigChanged(ThemeConfig::Changes changes);
+
         void updateBorders();
         void updateResizeBorders();
         void updateTitleBar();
+        void updateOpaque();
+        void updateBlurRegion();
+        QRegion titleBarShape() const;
+        int cornerRadius() const;
         void updateButtonsGeometry();
         void updateButtonsGeometryDelayed();
+        QRect captionRect() const;
+        void onCaptionChanged();
+        void repaintCaption();
+        int captionRepaintInterval() const;
         void updateShadow();
+        void updateDebugHud();
+        bool syncDebugHud();
+        void updateVisibility();
+        bool deferWhileHidden();
+        void refresh();
+
+        KDecoration2::DecorationButtonGroup *createButtonGroup(KDecoration2::DecorationButtonGroup::Position position);
+        bool isButtonNeeded(KDecoration2::DecorationButtonType type) const;
+        void materializeButton(KDecoration2::DecorationButtonType type);
 
         void paintFrameBackground(QPainter *painter, const QRect &repaintRegion) const;
         void paintTitleBarBackground(QPainter *painter, const QRect &repaintRegion) const;
         void paintCaption(QPainter *painter, const QRect &repaintRegion) const;
         void paintButtons(QPainter *painter, const QRect &repaintRegion) const;
-
-        static QSharedPointer<KDecoration2::DecorationShadow> createShadow(const CompositeShadowParams shadowParams, const qreal strength);
-
-        KDecoration2::DecorationButtonGroup *m_leftButtons;
-        KDecoration2::DecorationButtonGroup *m_rightButtons;
+        void paintCorners(QPainter *painter, const QRect &repaintRegion) const;
+
+        static QSharedPointer<KDecoration2::DecorationShadow> withoutEdges(
+                const QSharedPointer<KDecoration2::DecorationShadow> &shadow, Qt::Edges edges);
+
+        static int shadowSize(const CompositeShadowParams &shadowParams, const BoxShadowHelper::BlurSettings &blurSettings);
+        static QMargins shadowPadding(const CompositeShadowParams &shadowParams, const BoxShadowHelper::BlurSettings &blurSettings);
+        static QSharedPointer<KDecoration2::DecorationShadow> wrapShadow(const QImage &image, const QMargins &padding);
+
+        // Generates one shadow per strength, sharing the blur between them.
+        static QVector<QSharedPointer<KDecoration2::DecorationShadow>> createShadows(const CompositeShadowParams shadowParams, const QColor &color, const int cornerRadius, const BoxShadowHelper::BlurSettings &blurSettings, const QVector<qreal> &strengths);
+
+        KDecoration2::DecorationButtonGroup *m_leftButtons = nullptr;
+        KDecoration2::DecorationButtonGroup *m_rightButtons = nullptr;
+
+        QRegion m_blurRegion;
+
+        // Where the buttons and the caption were last laid out, so that a
+        // relayout only damages what actually moved.
+        struct Layout
+        {
+            QRect leftButtons;
+            QRect rightButtons;
+            QRect caption;
+        };
+        Layout m_layout;
+        bool m_updatingButtonsGeometry = false;
+
+        struct ElidedCaption
+        {
+            QString caption;
+            int width = -1;
+            QFont font;
+            QString text;
+        };
+        mutable ElidedCaption m_elidedCaption;
+
+        // Rate limit for caption repaints. The first change after a quiet
+        // period repaints right away and starts the timer, later changes
+        // only mark the caption pending until it fires.
+        QTimer m_captionTimer;
+        bool m_captionPending = false;
+
+        // Reused by the paint functions, so that repainting an unchanged
+        // decoration doesn't allocate.
+        mutable SolidBrush m_frameBrush;
+        mutable SolidBrush m_titleBarBrush;
+        mutable SolidPen m_captionPen;
+
+        // Only exists while the debug HUD is enabled.
+        std::unique_ptr<DebugHud> m_hud;
+
+        // Windows on other desktops don't invalidate anything. They only
+        // remember that they are dirty and catch up with a single refresh
+        // once they are visible again.
+        bool m_hidden = false;
+        bool m_dirty = false;
+
+        bool m_initialized = false;
+        // Set while paint() finishes a deferred init, which must not
+        // schedule any repaints.
+        bool m_painting = false;
+        QElapsedTimer m_initTimer;
+        qint64 m_timeToFirstFrame = -1;
     };
 }
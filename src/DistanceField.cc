@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "DistanceField.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace Fluent
+{
+    namespace DistanceField
+    {
+        namespace
+        {
+            const float INF = 1e20f;
+
+            // One dimensional squared distance transform from "Distance
+            // Transforms of Sampled Functions" by Felzenszwalb and
+            // Huttenlocher. Linear in the number of samples.
+            void transform1d(const float *f, int n, float *d, int *v, float *z)
+            {
+                int k = 0;
+                v[0] = 0;
+                z[0] = -INF;
+                z[1] = INF;
+
+                for (int q = 1; q < n; ++q) {
+                    float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+                    while (s <= z[k]) {
+                        --k;
+                        s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+                    }
+                    ++k;
+                    v[k] = q;
+                    z[k] = s;
+                    z[k + 1] = INF;
+                }
+
+                k = 0;
+                for (int q = 0; q < n; ++q) {
+                    while (z[k + 1] < q) {
+                        ++k;
+                    }
+                    d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+                }
+            }
+
+            // Squared distance from every pixel to the closest seed pixel.
+            std::vector<float> transform2d(const std::vector<bool> &seeds, int width, int height)
+            {
+                std::vector<float> grid(seeds.size());
+                for (size_t i = 0; i < seeds.size(); ++i) {
+                    grid[i] = seeds[i] ? 0.0f : INF;
+                }
+
+                const int length = qMax(width, height);
+                std::vector<float> f(length);
+                std::vector<float> d(length);
+                std::vector<int> v(length);
+                std::vector<float> z(length + 1);
+
+                for (int x = 0; x < width; ++x) {
+                    for (int y = 0; y < height; ++y) {
+                        f[y] = grid[size_t(y) * width + x];
+                    }
+                    transform1d(f.data(), height, d.data(), v.data(), z.data());
+                    for (int y = 0; y < height; ++y) {
+                        grid[size_t(y) * width + x] = d[y];
+                    }
+                }
+
+                for (int y = 0; y < height; ++y) {
+                    float *row = grid.data() + size_t(y) * width;
+                    std::copy(row, row + width, f.begin());
+                    transform1d(f.data(), width, row, v.data(), z.data());
+                }
+
+                return grid;
+            }
+        }
+
+        Field compute(const QPainterPath &shape, int margin)
+        {
+            Field field;
+            field.rect = shape.boundingRect().toAlignedRect().adjusted(-margin, -margin, margin, margin);
+            if (field.rect.isEmpty()) {
+                return field;
+            }
+
+            const int width = field.rect.width();
+            const int height = field.rect.height();
+
+            QImage mask(width, height, QImage::Format_Alpha8);
+            mask.fill(Qt::transparent);
+
+            QPainter painter(&mask);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(Qt::black);
+            painter.translate(-field.rect.topLeft());
+            painter.drawPath(shape);
+            painter.end();
+
+            std::vector<bool> inside(size_t(width) * height);
+            for (int y = 0; y < height; ++y) {
+                const uchar *line = mask.constScanLine(y);
+                for (int x = 0; x < width; ++x) {
+                    inside[size_t(y) * width + x] = line[x] >= 128;
+                }
+            }
+
+            std::vector<bool> outside(inside.size());
+            for (size_t i = 0; i < inside.size(); ++i) {
+                outside[i] = !inside[i];
+            }
+
+            const std::vector<float> toInside = transform2d(inside, width, height);
+            const std::vector<float> toOutside = transform2d(outside, width, height);
+
+            // The outline runs between pixel centers, half a pixel away
+            // from the closest pixel on the other side.
+            field.distances.resize(inside.size());
+            for (size_t i = 0; i < inside.size(); ++i) {
+                field.distances[i] = inside[i]
+                                     ? 0.5f - std::sqrt(toOutside[i])
+                                     : std::sqrt(toInside[i]) - 0.5f;
+            }
+
+            return field;
+        }
+
+        QImage shadow(const Field &field, qreal sigma, const QColor &color)
+        {
+            QImage image(field.rect.size(), QImage::Format_ARGB32_Premultiplied);
+            image.fill(Qt::transparent);
+            if (field.isNull()) {
+                return image;
+            }
+
+            const QRgb premultiplied = qPremultiply(color.rgba());
+            const qreal scale = sigma > 0 ? 1.0 / (sigma * M_SQRT2) : 0;
+
+            for (int y = 0; y < image.height(); ++y) {
+                QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+                for (int x = 0; x < image.width(); ++x) {
+                    const float distance = field.at(x, y);
+                    // Coverage of a Gaussian blurred half plane, exact for
+                    // straight edges but too dark past convex corners.
+                    const qreal coverage = sigma > 0
+                                           ? 0.5 * std::erfc(distance * scale)
+                                           : (distance <= 0 ? 1.0 : 0.0);
+                    const int a = qRound(coverage * 255);
+                    line[x] = qRgba(qRed(premultiplied) * a / 255,
+                                    qGreen(premultiplied) * a / 255,
+                                    qBlue(premultiplied) * a / 255,
+                                    qAlpha(premultiplied) * a / 255);
+                }
+            }
+
+            return image;
+        }
+    }
+}
@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "EventRecorder.h"
+#include "Decoration.h"
+
+// KDecoration
+#include <KDecoration2/DecoratedClient>
+
+// Qt
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QHoverEvent>
+#include <QMouseEvent>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace Fluent
+{
+    namespace
+    {
+        const quint32 MAGIC = 0x464c5243; // "FLRC"
+        const quint32 VERSION = 1;
+        const QDataStream::Version STREAM_VERSION = QDataStream::Qt_5_12;
+
+        void writeEvent(QDataStream &stream, const EventRecorder::Event &event)
+        {
+            stream << event.time << event.decoration << quint8(event.type);
+            if (event.isInput()) {
+                stream << event.position << event.button << event.buttons;
+            } else {
+                stream << event.value;
+            }
+        }
+
+        class RecordWriter
+        {
+        public:
+            RecordWriter()
+            {
+                const QByteArray fileName = qgetenv("FLUENT_RECORD_FILE");
+                if (fileName.isEmpty()) {
+                    return;
+                }
+
+                m_file.setFileName(QFile::decodeName(fileName));
+                if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                    qWarning("Fluent: could not open record file %s", fileName.constData());
+                    return;
+                }
+
+                m_stream.setDevice(&m_file);
+                m_stream.setVersion(STREAM_VERSION);
+                m_stream << MAGIC << VERSION;
+
+                m_timer.start();
+            }
+
+            bool isOpen() const
+            {
+                return m_file.isOpen();
+            }
+
+            quint32 add(const Decoration *decoration)
+            {
+                QMutexLocker locker(&m_mutex);
+                const quint32 id = ++m_lastId;
+                m_ids.insert(decoration, id);
+                return id;
+            }
+
+            quint32 remove(const Decoration *decoration)
+            {
+                QMutexLocker locker(&m_mutex);
+                return m_ids.take(decoration);
+            }
+
+            void write(const Decoration *decoration, EventRecorder::Event event)
+            {
+                QMutexLocker locker(&m_mutex);
+
+                event.decoration = m_ids.value(decoration);
+                if (event.decoration == 0) {
+                    return;
+                }
+                event.time = m_timer.nsecsElapsed() / 1000;
+
+                writeEvent(m_stream, event);
+
+                // Keep the recording usable if KWin goes down hard.
+                m_file.flush();
+            }
+
+            void write(EventRecorder::Event event)
+            {
+                QMutexLocker locker(&m_mutex);
+                event.time = m_timer.nsecsElapsed() / 1000;
+                writeEvent(m_stream, event);
+                m_file.flush();
+            }
+
+        private:
+            QFile m_file;
+            QDataStream m_stream;
+            QElapsedTimer m_timer;
+            QMutex m_mutex;
+            QHash<const Decoration *, quint32> m_ids;
+            quint32 m_lastId = 0;
+        };
+
+        RecordWriter *writer()
+        {
+            static RecordWriter s_writer;
+            return &s_writer;
+        }
+
+        void record(const Decoration *decoration, EventRecorder::EventType type, const QVariant &value)
+        {
+            EventRecorder::Event event;
+            event.type = type;
+            event.value = value;
+            writer()->write(decoration, event);
+        }
+    }
+
+    namespace EventRecorder
+    {
+        bool s_enabled = false;
+
+        void initialize()
+        {
+            s_enabled = writer()->isOpen();
+        }
+
+        void attach(Decoration *decoration)
+        {
+            const auto decoratedClient = decoration->client().toStrongRef();
+            if (!decoratedClient) {
+                return;
+            }
+
+            QVariantMap state;
+            state.insert(QStringLiteral("caption"), decoratedClient->caption());
+            state.insert(QStringLiteral("active"), decoratedClient->isActive());
+            state.insert(QStringLiteral("maximized"), decoratedClient->isMaximized());
+            state.insert(QStringLiteral("shaded"), decoratedClient->isShaded());
+            state.insert(QStringLiteral("size"), decoratedClient->size());
+            state.insert(QStringLiteral("closeable"), decoratedClient->isCloseable());
+            state.insert(QStringLiteral("maximizeable"), decoratedClient->isMaximizeable());
+            state.insert(QStringLiteral("minimizeable"), decoratedClient->isMinimizeable());
+            state.insert(QStringLiteral("providesContextHelp"), decoratedClient->providesContextHelp());
+            state.insert(QStringLiteral("adjacentScreenEdges"), int(decoratedClient->adjacentScreenEdges()));
+            state.insert(QStringLiteral("desktop"), decoratedClient->desktop());
+            state.insert(QStringLiteral("onAllDesktops"), decoratedClient->isOnAllDesktops());
+
+            Event created;
+            created.decoration = writer()->add(decoration);
+            created.type = EventType::Created;
+            created.value = state;
+            writer()->write(created);
+
+            auto *c = decoratedClient.data();
+            auto connectProperty = [decoration, c] (auto signal, EventType type) {
+                QObject::connect(c, signal, decoration, [decoration, type] (auto value) {
+                    record(decoration, type, QVariant::fromValue(value));
+                });
+            };
+
+            using KDecoration2::DecoratedClient;
+            connectProperty(&DecoratedClient::captionChanged, EventType::Caption);
+            connectProperty(&DecoratedClient::activeChanged, EventType::Active);
+            connectProperty(&DecoratedClient::maximizedChanged, EventType::Maximized);
+            connectProperty(&DecoratedClient::shadedChanged, EventType::Shaded);
+            connectProperty(&DecoratedClient::closeableChanged, EventType::Closeable);
+            connectProperty(&DecoratedClient::maximizeableChanged, EventType::Maximizeable);
+            connectProperty(&DecoratedClient::minimizeableChanged, EventType::Minimizeable);
+            connectProperty(&DecoratedClient::providesContextHelpChanged, EventType::ProvidesContextHelp);
+            connectProperty(&DecoratedClient::desktopChanged, EventType::Desktop);
+            connectProperty(&DecoratedClient::onAllDesktopsChanged, EventType::OnAllDesktops);
+
+            QObject::connect(c, &DecoratedClient::adjacentScreenEdgesChanged, decoration,
+                    [decoration] (Qt::Edges edges) {
+                        record(decoration, EventType::AdjacentScreenEdges, int(edges));
+                    });
+
+            // Width and height arrive separately, record the resulting size.
+            auto recordSize = [decoration, c] {
+                record(decoration, EventType::Size, c->size());
+            };
+            QObject::connect(c, &DecoratedClient::widthChanged, decoration, recordSize);
+            QObject::connect(c, &DecoratedClient::heightChanged, decoration, recordSize);
+        }
+
+        void detach(const Decoration *decoration)
+        {
+            Event destroyed;
+            destroyed.decoration = writer()->remove(decoration);
+            destroyed.type = EventType::Destroyed;
+            if (destroyed.decoration != 0) {
+                writer()->write(destroyed);
+            }
+        }
+
+        void recordInput(const Decoration *decoration, const QEvent *event)
+        {
+            Event input;
+
+            switch (event->type()) {
+                case QEvent::HoverEnter:
+                    input.type = EventType::HoverEnter;
+                    break;
+                case QEvent::HoverMove:
+                    input.type = EventType::HoverMove;
+                    break;
+                case QEvent::HoverLeave:
+                    input.type = EventType::HoverLeave;
+                    break;
+                case QEvent::MouseButtonPress:
+                    input.type = EventType::MousePress;
+                    break;
+                case QEvent::MouseButtonRelease:
+                    input.type = EventType::MouseRelease;
+                    break;
+                case QEvent::MouseMove:
+                    input.type = EventType::MouseMove;
+                    break;
+                default:
+                    return;
+            }
+
+            if (const auto *hover = dynamic_cast<const QHoverEvent *>(event)) {
+                input.position = hover->posF();
+            } else if (const auto *mouse = dynamic_cast<const QMouseEvent *>(event)) {
+                input.position = mouse->localPos();
+                input.button = mouse->button();
+                input.buttons = mouse->buttons();
+            }
+
+            writer()->write(decoration, input);
+        }
+
+        bool readHeader(QDataStream &stream)
+        {
+            stream.setVersion(STREAM_VERSION);
+
+            quint32 magic = 0;
+            quint32 version = 0;
+            stream >> magic >> version;
+            return stream.status() == QDataStream::Ok && magic == MAGIC && version == VERSION;
+        }
+
+        bool readEvent(QDataStream &stream, Event &event)
+        {
+            if (stream.atEnd()) {
+                return false;
+            }
+
+            quint8 type = 0;
+            stream >> event.time >> event.decoration >> type;
+            event.type = static_cast<EventType>(type);
+
+            if (event.isInput()) {
+                stream >> event.position >> event.button >> event.buttons;
+                event.value.clear();
+            } else {
+                stream >> event.value;
+            }
+
+            return stream.status() == QDataStream::Ok;
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QDataStream>
+#include <QEvent>
+#include <QPointF>
+#include <QVariant>
+
+namespace Fluent
+{
+    class Decoration;
+
+    // Optional recorder of everything a decoration reacts to. Set
+    // FLUENT_RECORD_FILE to a path and the plugin writes the client
+    // property changes and input events of all decorations there, which
+    // fluent-event-replay can play back against an offscreen decoration.
+    namespace EventRecorder
+    {
+        enum class EventType : quint8 {
+            // The value holds the initial client state as a QVariantMap.
+            Created,
+            Destroyed,
+
+            Caption,
+            Active,
+            Maximized,
+            Shaded,
+            Size,
+            Closeable,
+            Maximizeable,
+            Minimizeable,
+            ProvidesContextHelp,
+            AdjacentScreenEdges,
+            Desktop,
+            OnAllDesktops,
+
+            // Input events carry a position and the mouse buttons.
+            HoverEnter,
+            HoverMove,
+            HoverLeave,
+            MousePress,
+            MouseRelease,
+            MouseMove
+        };
+
+        struct Event
+        {
+            qint64 time = 0;
+            quint32 decoration = 0;
+            EventType type = EventType::Created;
+            QVariant value;
+            QPointF position;
+            quint32 button = 0;
+            quint32 buttons = 0;
+
+            bool isInput() const
+            {
+                return type >= EventType::HoverEnter;
+            }
+        };
+
+        extern bool s_enabled;
+
+        // Opens the recording file if one is configured. Called once from
+        // the plugin factory, until then nothing is recorded.
+        void initialize();
+
+        inline bool isEnabled()
+        {
+            return s_enabled;
+        }
+
+        // Starts recording the given decoration, beginning with a snapshot
+        // of its client.
+        void attach(Decoration *decoration);
+        void detach(const Decoration *decoration);
+
+        void recordInput(const Decoration *decoration, const QEvent *event);
+
+        // Reading recordings back.
+        bool readHeader(QDataStream &stream);
+        bool readEvent(QDataStream &stream, Event &event);
+    }
+}
@@ -19,19 +19,11 @@
 #include "FluentDecorationButton.h"
 #include "Decoration.h"
 
-// KDecoration
-#include <KDecoration2/DecoratedClient>
-
-// KF
-#include <KColorUtils>
-
-// Qt
-#include <QPainter>
-
 namespace Fluent
 {
     FluentDecorationButton::FluentDecorationButton(KDecoration2::DecorationButtonType type, Decoration *decoration, QObject *parent)
             : DecorationButton(type, decoration, parent)
+            , m_decoration(decoration)
     {
         connect(this, &FluentDecorationButton::hoveredChanged, this,
                 [this] {
@@ -44,38 +36,4 @@ namespace Fluent
     }
 
     FluentDecorationButton::~FluentDecorationButton() { }
-
-    QColor FluentDecorationButton::backgroundColor() const
-    {
-        const auto *deco = qobject_cast<Decoration *>(decoration());
-        if (!deco) {
-            return {};
-        }
-
-        if (isPressed()) {
-            return KColorUtils::mix(
-                    deco->titleBarBackgroundColor(),
-                    deco->titleBarForegroundColor(),
-                    0.3);
-        }
-
-        if (isHovered()) {
-            return KColorUtils::mix(
-                    deco->titleBarBackgroundColor(),
-                    deco->titleBarForegroundColor(),
-                    0.2);
-        }
-
-        return Qt::transparent;
-    }
-
-    QColor FluentDecorationButton::foregroundColor() const
-    {
-        const auto *deco = qobject_cast<Decoration *>(decoration());
-        if (!deco) {
-            return {};
-        }
-
-        return deco->titleBarForegroundColor();
-    }
-}
\ No newline at end of file
+}
@@ -17,13 +17,18 @@
 
 #pragma once
 
+// own
+#include "Decoration.h"
+#include "PainterState.h"
+
 // KDecoration
 #include <KDecoration2/DecorationButton>
 
+// KF
+#include <KColorUtils>
+
 namespace Fluent
 {
-    class Decoration;
-
     class FluentDecorationButton : public KDecoration2::DecorationButton
     {
     Q_OBJECT
@@ -33,7 +38,41 @@ namespace Fluent
         ~FluentDecorationButton() override;
 
     protected:
-        virtual QColor backgroundColor() const;
-        virtual QColor foregroundColor() const;
+        // The default colors. Buttons that need others hide these, see
+        // ButtonRenderer, so there is no virtual call involved.
+        QColor backgroundColor() const;
+        QColor foregroundColor() const;
+
+        // The decoration owns the button, so it can be kept from the
+        // start instead of casting decoration() every time.
+        Decoration *const m_decoration;
+
+        // Pen and brush of the above colors, reused from frame to frame.
+        SolidBrush m_backgroundBrush;
+        SolidPen m_foregroundPen;
     };
+
+    inline QColor FluentDecorationButton::backgroundColor() const
+    {
+        if (isPressed()) {
+            return KColorUtils::mix(
+                    m_decoration->titleBarBackgroundColor(),
+                    m_decoration->titleBarForegroundColor(),
+                    0.3);
+        }
+
+        if (isHovered()) {
+            return KColorUtils::mix(
+                    m_decoration->titleBarBackgroundColor(),
+                    m_decoration->titleBarForegroundColor(),
+                    0.2);
+        }
+
+        return Qt::transparent;
+    }
+
+    inline QColor FluentDecorationButton::foregroundColor() const
+    {
+        return m_decoration->titleBarForegroundColor();
+    }
 }
@@ -31,7 +31,7 @@
 namespace Fluent
 {
     MaximizeButton::MaximizeButton(Decoration *decoration, QObject *parent)
-            : FluentDecorationButton(KDecoration2::DecorationButtonType::Maximize, decoration, parent)
+            : ButtonRenderer(KDecoration2::DecorationButtonType::Maximize, decoration, parent)
     {
         auto *decoratedClient = decoration->client().toStrongRef().data();
         connect(decoratedClient, &KDecoration2::DecoratedClient::maximizeableChanged,
@@ -40,46 +40,30 @@ namespace Fluent
         setVisible(decoratedClient->isMaximizeable());
     }
 
-    void MaximizeButton::paint(QPainter *painter, const QRect &repaintRegion)
+    void MaximizeButton::paintGlyph(QPainter *painter, const QRectF &buttonRect)
     {
-        Q_UNUSED(repaintRegion)
-
-        const QRectF buttonRect = geometry();
         QRectF maximizeRect = QRectF(0, 0, 10, 10);
         maximizeRect.moveCenter(buttonRect.center().toPoint());
 
-        painter->save();
-
-        painter->setRenderHints(QPainter::Antialiasing, false);
-
-        // Background.
-        painter->setPen(Qt::NoPen);
-        painter->setBrush(backgroundColor());
-        painter->drawRect(buttonRect);
-
-        // Foreground.
-        painter->setPen(foregroundColor());
-        painter->setBrush(Qt::NoBrush);
-
         if (isChecked()) {
-            painter->drawPolygon(QVector<QPointF> {
+            const QPointF back[] = {
                     maximizeRect.bottomLeft(),
                     maximizeRect.topLeft() + QPoint(0, 2),
                     maximizeRect.topRight() + QPointF(-2, 2),
                     maximizeRect.bottomRight() + QPointF(-2, 0)
-            });
+            };
+            painter->drawPolygon(back, 4);
 
-            painter->drawPolyline(QVector<QPointF> {
+            const QPointF front[] = {
                     maximizeRect.topLeft() + QPointF(2, 2),
                     maximizeRect.topLeft() + QPointF(2, 0),
                     maximizeRect.topRight(),
                     maximizeRect.bottomRight() + QPointF(0, -2),
                     maximizeRect.bottomRight() + QPointF(-2, -2)
-            });
+            };
+            painter->drawPolyline(front, 5);
         } else {
             painter->drawRect(maximizeRect);
         }
-
-        painter->restore();
     }
 }
@@ -27,18 +27,56 @@
 #include <KIconLoader>
 
 // Qt
+#include <QPaintDevice>
 #include <QPainter>
 
 namespace Fluent
 {
+    namespace
+    {
+        QPixmap renderIcon(const QIcon &icon, const QSize &size, qreal devicePixelRatio,
+                           QPalette palette, const QColor &foreground)
+        {
+            QPixmap pixmap(size * devicePixelRatio);
+            pixmap.setDevicePixelRatio(devicePixelRatio);
+            pixmap.fill(Qt::transparent);
+
+            QPainter painter(&pixmap);
+            const QRect rect(QPoint(0, 0), size);
+
+            // Monochrome icons take their color from the icon loader's
+            // palette, so they match the title bar text.
+            const QPalette activePalette = KIconLoader::global()->customPalette();
+
+            palette.setColor(QPalette::Foreground, foreground);
+            KIconLoader::global()->setCustomPalette(palette);
+            icon.paint(&painter, rect);
+
+            if (activePalette == QPalette())
+            {
+                KIconLoader::global()->resetPalette();
+            }
+            else
+            {
+                KIconLoader::global()->setCustomPalette(activePalette);
+            }
+
+            painter.end();
+            return pixmap;
+        }
+    }
+
     MenuButton::MenuButton(Decoration *decoration, QObject *parent)
             : DecorationButton(KDecoration2::DecorationButtonType::Menu, decoration, parent)
+            , m_decoration(decoration)
     {
         auto *decoratedClient = decoration->client().toStrongRef().data();
-        connect(decoratedClient, &KDecoration2::DecoratedClient::iconChanged, this,
-                [this] {
-                    update();
-                });
+        auto invalidateIcon = [this] {
+            m_iconKey = -1;
+            update();
+        };
+        connect(decoratedClient, &KDecoration2::DecoratedClient::iconChanged, this, invalidateIcon);
+        connect(decoratedClient, &KDecoration2::DecoratedClient::paletteChanged, this, invalidateIcon);
 
         const int titleBarHeight = decoration->titleBarHeight();
         const QSize size(titleBarHeight, titleBarHeight);
@@ -58,28 +96,22 @@ namespace Fluent
         QRectF iconRect( geometry().topLeft(), iconSize );
         iconRect.moveCenter(geometry().center().toPoint());
 
-        const auto *decoratedClient = decoration()->client().toStrongRef().data();
-        if (const auto *deco = qobject_cast<Decoration *>(decoration()))
-        {
-            const QPalette activePalette = KIconLoader::global()->customPalette();
-            QPalette palette = decoratedClient->palette();
+        const auto *decoratedClient = m_decoration->client().toStrongRef().data();
 
-            palette.setColor(QPalette::Foreground, deco->titleBarForegroundColor());
-            KIconLoader::global()->setCustomPalette(palette);
-            decoratedClient->icon().paint(painter, iconRect.toRect());
+        const QIcon icon = decoratedClient->icon();
+        const QColor color = m_decoration->titleBarForegroundColor();
+        const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
 
-            if (activePalette == QPalette())
-            {
-                KIconLoader::global()->resetPalette();
-            }
-            else
-            {
-                KIconLoader::global()->setCustomPalette(palette);
-            }
-        }
-        else
-        {
-            decoratedClient->icon().paint(painter, iconRect.toRect());
+        if (icon.cacheKey() != m_iconKey
+                || color != m_iconColor
+                || devicePixelRatio != m_iconDevicePixelRatio) {
+            m_iconKey = icon.cacheKey();
+            m_iconColor = color;
+            m_iconDevicePixelRatio = devicePixelRatio;
+            m_iconPixmap = renderIcon(icon, iconSize.toSize(), devicePixelRatio,
+                                      decoratedClient->palette(), color);
         }
+
+        painter->drawPixmap(iconRect.toRect().topLeft(), m_iconPixmap);
     }
 }
@@ -20,6 +20,10 @@
 // KDecoration
 #include <KDecoration2/DecorationButton>
 
+// Qt
+#include <QColor>
+#include <QPixmap>
+
 namespace Fluent
 {
     class Decoration;
@@ -33,5 +37,18 @@ namespace Fluent
         ~MenuButton() override;
 
         void paint(QPainter *painter, const QRect &repaintRegion) override;
+
+    private:
+        // The decoration owns the button, so it is kept from the start
+        // instead of casting decoration() on every paint.
+        Decoration *const m_decoration;
+
+        // The icon as last painted. Going through the icon loader (and its
+        // custom palette) every frame is expensive, so the icon is only
+        // rendered again when it, its color or the scale changed.
+        QPixmap m_iconPixmap;
+        qint64 m_iconKey = -1;
+        QColor m_iconColor;
+        qreal m_iconDevicePixelRatio = 0;
     };
 }
@@ -31,7 +31,7 @@
 namespace Fluent
 {
     MinimizeButton::MinimizeButton(Decoration *decoration, QObject *parent)
-            : FluentDecorationButton(KDecoration2::DecorationButtonType::Minimize, decoration, parent)
+            : ButtonRenderer(KDecoration2::DecorationButtonType::Minimize, decoration, parent)
     {
         auto *decoratedClient = decoration->client().toStrongRef().data();
         connect(decoratedClient, &KDecoration2::DecoratedClient::minimizeableChanged,
@@ -40,30 +40,13 @@ namespace Fluent
         setVisible(decoratedClient->isMinimizeable());
     }
 
-    void MinimizeButton::paint(QPainter *painter, const QRect &repaintRegion)
+    void MinimizeButton::paintGlyph(QPainter *painter, const QRectF &buttonRect)
     {
-        Q_UNUSED(repaintRegion)
-
-        const QRectF buttonRect = geometry();
         QRectF minimizeRect = QRectF(0, 0, 10, 10);
         minimizeRect.moveCenter(buttonRect.center().toPoint());
 
-        painter->save();
-
-        painter->setRenderHints(QPainter::Antialiasing, false);
-
-        // Background.
-        painter->setPen(Qt::NoPen);
-        painter->setBrush(backgroundColor());
-        painter->drawRect(buttonRect);
-
-        // Foreground.
-        painter->setPen(foregroundColor());
-        painter->setBrush(Qt::NoBrush);
         painter->drawLine(
                 minimizeRect.left(), minimizeRect.center().y(),
                 minimizeRect.right(), minimizeRect.center().y());
-
-        painter->restore();
     }
 }
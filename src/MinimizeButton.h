@@ -18,7 +18,7 @@
 #pragma once
 
 // own
-#include "FluentDecorationButton.h"
+#include "ButtonRenderer.h"
 
 // KDecoration
 #include <KDecoration2/DecorationButton>
@@ -27,13 +27,17 @@ namespace Fluent
 {
     class Decoration;
 
-    class MinimizeButton : public FluentDecorationButton
+    class MinimizeButton : public ButtonRenderer<MinimizeButton>
     {
     Q_OBJECT
 
     public:
         MinimizeButton(Decoration *decoration, QObject *parent = nullptr);
 
-        void paint(QPainter *painter, const QRect &repaintRegion) override;
+    private:
+        static constexpr bool Antialiased = false;
+        void paintGlyph(QPainter *painter, const QRectF &buttonRect);
+
+        friend class ButtonRenderer<MinimizeButton>;
     };
 }
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QBrush>
+#include <QColor>
+#include <QFont>
+#include <QPainter>
+#include <QPen>
+#include <QTransform>
+
+namespace Fluent
+{
+    // Puts back the painter's style (pen, brush, font, brush origin,
+    // render hints, composition mode and opacity) once it goes out of
+    // scope. QPainter::save() allocates a new state every time, which is
+    // too much for a paint path that runs every frame.
+    //
+    // The clip and the transform are not restored: reading the clip back
+    // allocates just like save() does. Code that changes either has to
+    // use save() and restore(), debug builds assert that nobody else did.
+    class PainterStyleGuard
+    {
+    public:
+        explicit PainterStyleGuard(QPainter *painter)
+                : m_painter(painter)
+                , m_pen(painter->pen())
+                , m_brush(painter->brush())
+                , m_font(painter->font())
+                , m_brushOrigin(painter->brushOrigin())
+                , m_renderHints(painter->renderHints())
+                , m_compositionMode(painter->compositionMode())
+                , m_opacity(painter->opacity())
+                , m_transform(painter->transform())
+                , m_hasClipping(painter->hasClipping()) {}
+
+        ~PainterStyleGuard()
+        {
+            Q_ASSERT(m_painter->transform() == m_transform);
+            Q_ASSERT(m_painter->hasClipping() == m_hasClipping);
+
+            m_painter->setPen(m_pen);
+            m_painter->setBrush(m_brush);
+            m_painter->setCompositionMode(m_compositionMode);
+            m_painter->setOpacity(m_opacity);
+
+            // These setters don't check whether anything changed, and
+            // setFont() even resolves a new font every time.
+            if (m_painter->font() != m_font) {
+                m_painter->setFont(m_font);
+            }
+            if (m_painter->brushOrigin() != m_brushOrigin) {
+                m_painter->setBrushOrigin(m_brushOrigin);
+            }
+            if (m_painter->renderHints() != m_renderHints) {
+                m_painter->setRenderHints(~m_renderHints, false);
+                m_painter->setRenderHints(m_renderHints, true);
+            }
+        }
+
+        PainterStyleGuard(const PainterStyleGuard &) = delete;
+        PainterStyleGuard &operator=(const PainterStyleGuard &) = delete;
+
+    private:
+        QPainter *m_painter;
+        const QPen m_pen;
+        const QBrush m_brush;
+        const QFont m_font;
+        const QPointF m_brushOrigin;
+        const QPainter::RenderHints m_renderHints;
+        const QPainter::CompositionMode m_compositionMode;
+        const qreal m_opacity;
+        const QTransform m_transform;
+        const bool m_hasClipping;
+    };
+
+    // A solid pen or brush that is only rebuilt when its color changes.
+    // Building a QPen or QBrush from a color allocates, reusing one only
+    // bumps a reference count.
+    template<typename T>
+    class SolidColor
+    {
+    public:
+        const T &operator()(const QColor &color)
+        {
+            if (!m_valid || color != m_color) {
+                m_value = T(color);
+                m_color = color;
+                m_valid = true;
+            }
+            return m_value;
+        }
+
+    private:
+        T m_value;
+        QColor m_color;
+        bool m_valid = false;
+    };
+
+    using SolidPen = SolidColor<QPen>;
+    using SolidBrush = SolidColor<QBrush>;
+}
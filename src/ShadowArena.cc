@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "ShadowArena.h"
+
+// Qt
+#include <QCoreApplication>
+#include <QTimer>
+#include <QVector>
+
+namespace Fluent
+{
+    namespace ShadowArena
+    {
+        namespace
+        {
+            const size_t ALIGNMENT = 64;
+
+            // Configuration changes regenerate several shadows in a row,
+            // keep the buffers around for those.
+            const int IDLE_TIMEOUT = 30 * 1000;
+
+            struct Buffer
+            {
+                void *data = nullptr;
+                size_t size = 0;
+            };
+
+            QVector<Buffer> &buffers()
+            {
+                static QVector<Buffer> s_buffers;
+                return s_buffers;
+            }
+
+            void scheduleRelease()
+            {
+                static QTimer *s_timer = nullptr;
+                if (!s_timer) {
+                    s_timer = new QTimer(QCoreApplication::instance());
+                    s_timer->setSingleShot(true);
+                    s_timer->setInterval(IDLE_TIMEOUT);
+                    QObject::connect(s_timer, &QTimer::timeout, &release);
+                }
+                s_timer->start();
+            }
+        }
+
+        void *acquire(int slot, size_t size)
+        {
+            QVector<Buffer> &all = buffers();
+            if (slot >= all.size()) {
+                all.resize(slot + 1);
+            }
+
+            Buffer &buffer = all[slot];
+            if (buffer.size < size) {
+                qFreeAligned(buffer.data);
+                buffer.data = qMallocAligned(size, ALIGNMENT);
+                Q_CHECK_PTR(buffer.data);
+                buffer.size = size;
+            }
+
+            scheduleRelease();
+            return buffer.data;
+        }
+
+        QImage image(int slot, const QSize &size, qreal devicePixelRatio)
+        {
+            const int bytesPerLine = size.width() * 4;
+            uchar *data = static_cast<uchar *>(acquire(slot, size_t(bytesPerLine) * size.height()));
+
+            QImage image(data, size.width(), size.height(), bytesPerLine, QImage::Format_ARGB32_Premultiplied);
+            image.setDevicePixelRatio(devicePixelRatio);
+            image.fill(Qt::transparent);
+            return image;
+        }
+
+        void release()
+        {
+            QVector<Buffer> &all = buffers();
+            for (Buffer &buffer : all) {
+                qFreeAligned(buffer.data);
+            }
+            all.clear();
+            all.squeeze();
+        }
+
+        size_t reservedBytes()
+        {
+            size_t bytes = 0;
+            for (const Buffer &buffer : buffers()) {
+                bytes += buffer.size;
+            }
+            return bytes;
+        }
+    }
+}
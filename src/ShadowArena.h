@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QImage>
+#include <QSize>
+
+namespace Fluent
+{
+    // Scratch memory for shadow generation. Every slot keeps one aligned
+    // buffer that only grows, so once the largest shadow has been made,
+    // generating shadows doesn't allocate any more. The buffers are freed
+    // when no shadow has been generated for a while.
+    //
+    // Only meant for the thread that generates shadows (KWin's main
+    // thread), and nothing in here is thread-safe.
+    namespace ShadowArena
+    {
+        enum Slot {
+            WorkSlot,
+            TransposedSlot,
+            AlphaSlot,
+            LineSlot,
+            TableSlot,
+            TintSlot,
+            MaskSlot
+        };
+
+        // At least size bytes of 64-byte aligned memory. The contents stay
+        // valid until the slot is acquired again or the arena is released.
+        void *acquire(int slot, size_t size);
+
+        template <typename T>
+        T *acquire(int slot, size_t count)
+        {
+            return static_cast<T *>(acquire(slot, count * sizeof(T)));
+        }
+
+        // A transparent premultiplied ARGB32 image on top of the slot's
+        // memory. Copies of it detach as usual.
+        QImage image(int slot, const QSize &size, qreal devicePixelRatio);
+
+        void release();
+
+        // Memory currently held by the arena, in bytes.
+        size_t reservedBytes();
+    }
+}
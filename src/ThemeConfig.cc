@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "ThemeConfig.h"
+#include "Trace.h"
+
+// KF
+#include <KConfigGroup>
+
+namespace Fluent
+{
+    ThemeConfig *ThemeConfig::self()
+    {
+        static ThemeConfig s_self;
+        return &s_self;
+    }
+
+    ThemeConfig::ThemeConfig()
+            : m_config(KSharedConfig::openConfig(QStringLiteral("fluentdecorationrc")))
+            , m_values(read())
+    {
+    }
+
+    const ThemeConfig::Values &ThemeConfig::defaults()
+    {
+        static const Values s_defaults;
+        return s_defaults;
+    }
+
+    bool ThemeConfig::hasDefaultShadow() const
+    {
+        const Values &d = defaults();
+        return m_values.shadowParams == d.shadowParams
+               && m_values.shadowColor == d.shadowColor
+               && m_values.shadowBlurSettings == d.shadowBlurSettings
+               && m_values.cornerRadius == d.cornerRadius;
+    }
+
+    void ThemeConfig::watch(const QSharedPointer<KDecoration2::DecorationSettings> &settings)
+    {
+        connect(settings.data(), &KDecoration2::DecorationSettings::reconfigured,
+                this, &ThemeConfig::reload, Qt::UniqueConnection);
+    }
+
+    void ThemeConfig::reload()
+    {
+        FLUENT_TRACE_SCOPE("ThemeConfig::reload", nullptr);
+
+        m_config->reparseConfiguration();
+
+        const Values values = read();
+
+        Changes changes = NoChange;
+
+        if (values.titleBarOpacityActive != m_values.titleBarOpacityActive
+                || values.titleBarOpacityInactive != m_values.titleBarOpacityInactive
+                || values.opaqueTitleBar != m_values.opaqueTitleBar
+                || values.acrylicTitleBar != m_values.acrylicTitleBar
+                || values.acrylicNoiseOpacity != m_values.acrylicNoiseOpacity) {
+            changes |= TitleBarChanged;
+        }
+
+        // The corner radius changes the title bar shape as well as the
+        // cut-out of the shadow.
+        if (values.cornerRadius != m_values.cornerRadius) {
+            changes |= TitleBarChanged;
+        }
+
+        if (values.shadowParams != m_values.shadowParams
+                || values.shadowColor != m_values.shadowColor
+                || values.shadowBlurSettings != m_values.shadowBlurSettings
+                || values.cornerRadius != m_values.cornerRadius) {
+            changes |= ShadowChanged;
+            ++m_shadowRevision;
+        }
+
+        if (values.debugHud != m_values.debugHud) {
+            changes |= DebugHudChanged;
+        }
+
+        m_values = values;
+
+        if (changes != NoChange) {
+            emit changed(changes);
+        }
+    }
+
+    ThemeConfig::Values ThemeConfig::read() const
+    {
+        const Values defaults;
+        Values values;
+
+        const KConfigGroup titleBar = m_config->group("TitleBar");
+        values.titleBarOpacityActive = qBound(0.0, titleBar.readEntry("OpacityActive", defaults.titleBarOpacityActive), 1.0);
+        values.titleBarOpacityInactive = qBound(0.0, titleBar.readEntry("OpacityInactive", defaults.titleBarOpacityInactive), 1.0);
+        values.opaqueTitleBar = titleBar.readEntry("Opaque", defaults.opaqueTitleBar);
+        values.acrylicTitleBar = titleBar.readEntry("Acrylic", defaults.acrylicTitleBar);
+        values.acrylicNoiseOpacity = qBound(0.0, titleBar.readEntry("AcrylicNoiseOpacity", defaults.acrylicNoiseOpacity), 1.0);
+        values.maxCaptionRate = qMax(0, titleBar.readEntry("MaxCaptionRate", defaults.maxCaptionRate));
+
+        // The rounded part has to fit into the corner tiles of the shadow.
+        const KConfigGroup window = m_config->group("Window");
+        values.cornerRadius = qBound(0, window.readEntry("CornerRadius", defaults.cornerRadius), 24);
+
+        const KConfigGroup shadow = m_config->group("Shadow");
+        values.shadowColor = shadow.readEntry("Color", defaults.shadowColor);
+        values.shadowParams.offset = shadow.readEntry("Offset", defaults.shadowParams.offset);
+
+        auto readLayer = [&shadow] (const QString &prefix, const ShadowParams &fallback) {
+            ShadowParams params;
+            params.offset = shadow.readEntry(prefix + QStringLiteral("Offset"), fallback.offset);
+            params.radius = qMax(0, shadow.readEntry(prefix + QStringLiteral("Radius"), fallback.radius));
+            params.opacity = qBound(0.0, shadow.readEntry(prefix + QStringLiteral("Opacity"), fallback.opacity), 1.0);
+            return params;
+        };
+
+        // The "shape" layer gives the shadow its body, the "contrast" layer
+        // darkens the area right next to the window.
+        values.shadowParams.shadow1 = readLayer(QStringLiteral("Shape"), defaults.shadowParams.shadow1);
+        values.shadowParams.shadow2 = readLayer(QStringLiteral("Contrast"), defaults.shadowParams.shadow2);
+
+        const QString engine = shadow.readEntry("Engine", QStringLiteral("Box"));
+        if (engine == QLatin1String("SummedArea")) {
+            values.shadowBlurSettings.engine = BoxShadowHelper::BlurEngine::SummedArea;
+        } else if (engine == QLatin1String("ExtendedBox")) {
+            values.shadowBlurSettings.engine = BoxShadowHelper::BlurEngine::ExtendedBox;
+        } else if (engine == QLatin1String("Gaussian")) {
+            values.shadowBlurSettings.engine = BoxShadowHelper::BlurEngine::Gaussian;
+        } else if (engine == QLatin1String("DistanceField")) {
+            values.shadowBlurSettings.engine = BoxShadowHelper::BlurEngine::DistanceField;
+        } else {
+            values.shadowBlurSettings.engine = BoxShadowHelper::BlurEngine::Box;
+        }
+        values.shadowBlurSettings.iterations = qBound(1, shadow.readEntry("BoxIterations", defaults.shadowBlurSettings.iterations), 5);
+
+        const KConfigGroup debug = m_config->group("Debug");
+        values.debugHud = debug.readEntry("Hud", defaults.debugHud)
+                          || qEnvironmentVariableIsSet("FLUENT_DEBUG_HUD");
+
+        return values;
+    }
+}
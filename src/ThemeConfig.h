@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// own
+#include "BoxShadowHelper.h"
+
+// KDecoration
+#include <KDecoration2/DecorationSettings>
+
+// KF
+#include <KSharedConfig>
+
+// Qt
+#include <QColor>
+#include <QObject>
+#include <QPoint>
+#include <QSharedPointer>
+
+namespace Fluent
+{
+    struct ShadowParams
+    {
+        ShadowParams() = default;
+
+        ShadowParams(const QPoint &offset, int radius, qreal opacity)
+                : offset(offset)
+                , radius(radius)
+                , opacity(opacity) {}
+
+        bool operator==(const ShadowParams &other) const
+        {
+            return offset == other.offset
+                   && radius == other.radius
+                   && opacity == other.opacity;
+        }
+
+        bool operator!=(const ShadowParams &other) const
+        {
+            return !(*this == other);
+        }
+
+        QPoint offset;
+        int radius = 0;
+        qreal opacity = 0;
+    };
+
+    struct CompositeShadowParams
+    {
+        CompositeShadowParams() = default;
+
+        CompositeShadowParams(
+                const QPoint &offset,
+                const ShadowParams &shadow1,
+                const ShadowParams &shadow2)
+                : offset(offset)
+                , shadow1(shadow1)
+                , shadow2(shadow2) {}
+
+        bool operator==(const CompositeShadowParams &other) const
+        {
+            return offset == other.offset
+                   && shadow1 == other.shadow1
+                   && shadow2 == other.shadow2;
+        }
+
+        bool operator!=(const CompositeShadowParams &other) const
+        {
+            return !(*this == other);
+        }
+
+        QPoint offset;
+        ShadowParams shadow1;
+        ShadowParams shadow2;
+    };
+
+    // Theme tuning values, read from fluentdecorationrc and shared by all
+    // decorations. On reconfigure the file is read once and compared with
+    // the previous values, so decorations only redo what actually changed.
+    class ThemeConfig : public QObject
+    {
+    Q_OBJECT
+
+    public:
+        enum Change {
+            NoChange = 0,
+            TitleBarChanged = 1 << 0,
+            ShadowChanged = 1 << 1,
+            DebugHudChanged = 1 << 2
+        };
+        Q_DECLARE_FLAGS(Changes, Change)
+
+        struct Values
+        {
+            qreal titleBarOpacityActive = 0.8;
+            qreal titleBarOpacityInactive = 0.8;
+            bool opaqueTitleBar = false;
+            bool acrylicTitleBar = false;
+            qreal acrylicNoiseOpacity = 0.02;
+            int cornerRadius = 0;
+            int maxCaptionRate = 0;
+
+            CompositeShadowParams shadowParams = CompositeShadowParams(
+                    QPoint(0, 12),
+                    ShadowParams(QPoint(0, 0), 48, 0.8),
+                    ShadowParams(QPoint(0, -6), 24, 0.2));
+            QColor shadowColor = QColor(0, 0, 0);
+            BoxShadowHelper::BlurSettings shadowBlurSettings;
+
+            bool debugHud = false;
+        };
+
+        static ThemeConfig *self();
+
+        // The built-in defaults, whatever the configuration file says.
+        static const Values &defaults();
+
+        // Reloads the configuration whenever the given settings are
+        // reconfigured. Safe to call for every decoration.
+        void watch(const QSharedPointer<KDecoration2::DecorationSettings> &settings);
+
+        qreal titleBarOpacityActive() const { return m_values.titleBarOpacityActive; }
+        qreal titleBarOpacityInactive() const { return m_values.titleBarOpacityInactive; }
+
+        // Paint the title bar without translucency, so that the compositor
+        // can skip whatever is behind it (including blur).
+        bool opaqueTitleBar() const { return m_values.opaqueTitleBar; }
+
+        // Lay a subtle noise texture over the title bar, like Fluent's
+        // acrylic material does.
+        bool acrylicTitleBar() const { return m_values.acrylicTitleBar; }
+        qreal acrylicNoiseOpacity() const { return m_values.acrylicNoiseOpacity; }
+
+        // Radius of the rounded top corners, 0 for square windows.
+        int cornerRadius() const { return m_values.cornerRadius; }
+
+        // How often per second a window may repaint its caption, for apps
+        // that retitle all the time. 0 follows the display refresh rate.
+        int maxCaptionRate() const { return m_values.maxCaptionRate; }
+
+        CompositeShadowParams shadowParams() const { return m_values.shadowParams; }
+        QColor shadowColor() const { return m_values.shadowColor; }
+
+        // Which blur the shadows are generated with, see BoxShadowHelper.
+        BoxShadowHelper::BlurSettings shadowBlurSettings() const { return m_values.shadowBlurSettings; }
+
+        // Show the debug overlay in the title bar. Also switched on by the
+        // FLUENT_DEBUG_HUD environment variable.
+        bool debugHud() const { return m_values.debugHud; }
+
+        // True if everything the shadows depend on is at its default, so
+        // the shadows baked in at build time can be used as they are.
+        bool hasDefaultShadow() const;
+
+        // Bumped every time the shadow values change. Cached shadows built
+        // for an older revision are stale.
+        int shadowRevision() const { return m_shadowRevision; }
+
+    public slots:
+        void reload();
+
+    signals:
+        void changed(Fluent::ThemeConfig::Changes changes);
+
+    private:
+        ThemeConfig();
+
+        Values read() const;
+
+        KSharedConfig::Ptr m_config;
+        Values m_values;
+        int m_shadowRevision = 0;
+    };
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Fluent::ThemeConfig::Changes)
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "Trace.h"
+#include "Decoration.h"
+
+// KDecoration
+#include <KDecoration2/DecoratedClient>
+
+// Qt
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+
+// std
+#include <chrono>
+
+// system
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Fluent
+{
+    namespace
+    {
+        class TraceWriter
+        {
+        public:
+            TraceWriter()
+            {
+                const QByteArray fileName = qgetenv("FLUENT_TRACE_FILE");
+                if (fileName.isEmpty()) {
+                    return;
+                }
+
+                m_file.setFileName(QFile::decodeName(fileName));
+                if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                    qWarning("Fluent: could not open trace file %s", fileName.constData());
+                    return;
+                }
+
+                // The JSON array format doesn't require the closing bracket,
+                // so the trace stays readable even if KWin goes down hard.
+                m_file.write("[\n");
+            }
+
+            ~TraceWriter()
+            {
+                if (m_file.isOpen()) {
+                    m_file.write("\n]\n");
+                    m_file.close();
+                }
+            }
+
+            bool isOpen() const
+            {
+                return m_file.isOpen();
+            }
+
+            void write(QJsonObject event)
+            {
+                event.insert(QStringLiteral("pid"), QCoreApplication::applicationPid());
+                event.insert(QStringLiteral("tid"), static_cast<qint64>(::syscall(SYS_gettid)));
+
+                const QByteArray json = QJsonDocument(event).toJson(QJsonDocument::Compact);
+
+                QMutexLocker locker(&m_mutex);
+                if (!m_first) {
+                    m_file.write(",\n");
+                }
+                m_first = false;
+                m_file.write(json);
+            }
+
+        private:
+            QFile m_file;
+            QMutex m_mutex;
+            bool m_first = true;
+        };
+
+        TraceWriter *writer()
+        {
+            static TraceWriter s_writer;
+            return &s_writer;
+        }
+
+        QJsonObject clientArgs(const Decoration *decoration)
+        {
+            QJsonObject args;
+            if (!decoration) {
+                return args;
+            }
+
+            const auto decoratedClient = decoration->client().toStrongRef();
+            if (!decoratedClient) {
+                return args;
+            }
+
+            args.insert(QStringLiteral("caption"), decoratedClient->caption());
+            args.insert(QStringLiteral("width"), decoratedClient->width());
+            args.insert(QStringLiteral("height"), decoratedClient->height());
+            return args;
+        }
+    }
+
+    namespace Trace
+    {
+        bool s_enabled = false;
+
+        void initialize()
+        {
+            s_enabled = writer()->isOpen();
+        }
+
+        qint64 now()
+        {
+            // steady_clock is CLOCK_MONOTONIC, the same clock KWin and
+            // Perfetto use for their own timestamps.
+            const auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count();
+        }
+
+        void complete(const char *name, qint64 start, qint64 end, const Decoration *decoration)
+        {
+            QJsonObject event;
+            event.insert(QStringLiteral("name"), QLatin1String(name));
+            event.insert(QStringLiteral("cat"), QStringLiteral("fluent"));
+            event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+            event.insert(QStringLiteral("ts"), start);
+            event.insert(QStringLiteral("dur"), end - start);
+            event.insert(QStringLiteral("args"), clientArgs(decoration));
+            writer()->write(event);
+        }
+
+        void instant(const char *name, const Decoration *decoration)
+        {
+            QJsonObject event;
+            event.insert(QStringLiteral("name"), QLatin1String(name));
+            event.insert(QStringLiteral("cat"), QStringLiteral("fluent"));
+            event.insert(QStringLiteral("ph"), QStringLiteral("i"));
+            event.insert(QStringLiteral("s"), QStringLiteral("t"));
+            event.insert(QStringLiteral("ts"), now());
+            event.insert(QStringLiteral("args"), clientArgs(decoration));
+            writer()->write(event);
+        }
+    }
+}
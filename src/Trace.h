@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QtGlobal>
+
+namespace Fluent
+{
+    class Decoration;
+
+    // Optional trace-event recorder. Set FLUENT_TRACE_FILE to a path and the
+    // plugin writes Chrome JSON trace events there, which can be opened in
+    // chrome://tracing or ui.perfetto.dev next to a KWin trace. Timestamps
+    // come from the monotonic clock, so both timelines line up.
+    namespace Trace
+    {
+        extern bool s_enabled;
+
+        // Opens the trace file if one is configured. Called once from the
+        // plugin factory, until then tracing is off.
+        void initialize();
+
+        inline bool isEnabled()
+        {
+            return s_enabled;
+        }
+
+        qint64 now();
+
+        void complete(const char *name, qint64 start, qint64 end, const Decoration *decoration);
+        void instant(const char *name, const Decoration *decoration);
+    }
+
+    class TraceScope
+    {
+    public:
+        explicit TraceScope(const char *name, const Decoration *decoration = nullptr)
+                : m_name(name)
+                , m_decoration(decoration)
+                , m_active(Trace::isEnabled())
+        {
+            if (Q_UNLIKELY(m_active)) {
+                m_start = Trace::now();
+            }
+        }
+
+        ~TraceScope()
+        {
+            if (Q_UNLIKELY(m_active)) {
+                Trace::complete(m_name, m_start, Trace::now(), m_decoration);
+            }
+        }
+
+        TraceScope(const TraceScope &) = delete;
+        TraceScope &operator=(const TraceScope &) = delete;
+
+    private:
+        const char *m_name;
+        const Decoration *m_decoration;
+        const bool m_active;
+        qint64 m_start = 0;
+    };
+}
+
+#define FLUENT_TRACE_CONCAT_IMPL(a, b) a##b
+#define FLUENT_TRACE_CONCAT(a, b) FLUENT_TRACE_CONCAT_IMPL(a, b)
+
+#define FLUENT_TRACE_SCOPE(name, decoration) \
+    const Fluent::TraceScope FLUENT_TRACE_CONCAT(fluentTraceScope, __LINE__)(name, decoration)
+
+#define FLUENT_TRACE_INSTANT(name, decoration)         \
+    do {                                               \
+        if (Q_UNLIKELY(Fluent::Trace::isEnabled())) {  \
+            Fluent::Trace::instant(name, decoration);  \
+        }                                              \
+    } while (false)
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "WindowVisibility.h"
+#include "Trace.h"
+
+namespace Fluent
+{
+    WindowVisibility *WindowVisibility::self()
+    {
+        static WindowVisibility s_self;
+        return &s_self;
+    }
+
+    void WindowVisibility::windowActivated(int desktop, bool onAllDesktops)
+    {
+        const int currentDesktop = onAllDesktops ? 0 : desktop;
+        if (currentDesktop == m_currentDesktop) {
+            return;
+        }
+
+        m_currentDesktop = currentDesktop;
+
+        FLUENT_TRACE_INSTANT("currentDesktopChanged", nullptr);
+        emit currentDesktopChanged(currentDesktop);
+    }
+}
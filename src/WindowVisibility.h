@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QObject>
+
+namespace Fluent
+{
+    // Shared knowledge about which virtual desktop is being shown.
+    // Decorations of windows on other desktops use it to put off
+    // invalidation work until they are shown again.
+    //
+    // KDecoration2 doesn't report the current desktop, but KWin only
+    // activates windows on the current one. So the desktop of the window
+    // that was activated last is the current desktop. It is unknown until
+    // the first activation, or while the active window is on all desktops;
+    // every window counts as visible then.
+    class WindowVisibility : public QObject
+    {
+    Q_OBJECT
+
+    public:
+        static WindowVisibility *self();
+
+        // The current desktop, or 0 while it is unknown.
+        int currentDesktop() const { return m_currentDesktop; }
+
+        // Decorations report the desktop of their window when it gets
+        // activated.
+        void windowActivated(int desktop, bool onAllDesktops);
+
+    signals:
+        void currentDesktopChanged(int desktop);
+
+    private:
+        WindowVisibility() = default;
+
+        int m_currentDesktop = 0;
+    };
+}
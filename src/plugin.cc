@@ -17,13 +17,20 @@
 
 // own
 #include "Decoration.h"
+#include "EventRecorder.h"
+#include "Trace.h"
 
 // KF
 #include <KPluginFactory>
 
+// Tracing and recording check the environment once, before the first
+// decoration exists, instead of relying on the order of static
+// initializers.
 K_PLUGIN_FACTORY_WITH_JSON(
     FluentDecorationFactory,
     "fluent.json",
-    registerPlugin<Fluent::Decoration>(););
+    registerPlugin<Fluent::Decoration>();
+    Fluent::Trace::initialize();
+    Fluent::EventRecorder::initialize();)
 
 #include "plugin.moc"
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020 SuNNjek <sunnerlp@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Renders the shadows of the default configuration and writes them out as
+// a C++ source file, which is compiled into the plugin. KWin then doesn't
+// have to blur them again every time it starts.
+
+// own
+#include "Decoration.h"
+
+// Qt
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+
+using namespace Fluent;
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList arguments = app.arguments();
+    if (arguments.size() != 2) {
+        qCritical("Usage: %s <output.cc>", qPrintable(arguments.first()));
+        return 1;
+    }
+
+    const QVector<QImage> shadows = Decoration::renderDefaultShadows();
+    if (shadows.size() != 2) {
+        qCritical("Expected an active and an inactive shadow");
+        return 1;
+    }
+
+    QFile file(arguments.at(1));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCritical("Could not open %s", qPrintable(file.fileName()));
+        return 1;
+    }
+
+    QTextStream out(&file);
+    out << "// Generated by fluent-shadow-baker, do not edit.\n\n"
+        << "#include \"BakedShadows.h\"\n\n"
+        << "#include <QtGlobal>\n\n"
+        << "namespace Fluent\n"
+        << "{\n"
+        << "    namespace\n"
+        << "    {\n";
+
+    // Pixels are written as 32-bit words, so the data has the byte order
+    // QImage expects on the machine that compiles it.
+    const char *names[] = { "s_active", "s_inactive" };
+    for (int i = 0; i < shadows.size(); ++i) {
+        const QImage image = shadows.at(i).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+        out << "        const quint32 " << names[i] << "[] = {";
+        int column = 0;
+        for (int y = 0; y < image.height(); ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            for (int x = 0; x < image.width(); ++x) {
+                out << (column++ % 8 == 0 ? "\n            " : " ")
+                    << "0x" << QString::number(line[x], 16).rightJustified(8, QLatin1Char('0')) << ",";
+            }
+        }
+        out << "\n        };\n\n";
+    }
+
+    out << "        const BakedShadows::Shadow s_shadows[] = {\n";
+    for (int i = 0; i < shadows.size(); ++i) {
+        out << "            { " << (i == 0 ? "true" : "false") << ", "
+            << shadows.at(i).width() << ", " << shadows.at(i).height() << ", " << names[i] << " },\n";
+    }
+    out << "        };\n\n"
+        << "        void installBakedShadows()\n"
+        << "        {\n"
+        << "            BakedShadows::install(s_shadows, " << shadows.size() << ");\n"
+        << "        }\n"
+        << "    }\n\n"
+        << "    Q_CONSTRUCTOR_FUNCTION(installBakedShadows)\n"
+        << "}\n";
+
+    return 0;
+}